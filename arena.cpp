@@ -0,0 +1,61 @@
+#include "arena.h"
+
+Arena::Arena(byte *buffer, size_t size) {
+    this->buffer = buffer;
+    this->size = size;
+}
+
+void *Arena::allocate(size_t bytes) {
+    // align on the actual address, the buffer itself may not be aligned
+    uintptr_t address = (uintptr_t) (this->buffer + this->used);
+    size_t start = this->used + ((ALIGNMENT - address % ALIGNMENT) % ALIGNMENT);
+    if (start + bytes > this->size) {
+        this->failures++;
+        return NULL;
+    }
+    this->used = start + bytes;
+    if (this->used > this->highWaterMark) {
+        this->highWaterMark = this->used;
+    }
+    return this->buffer + start;
+}
+
+void Arena::reset(void) {
+    this->used = 0;
+}
+
+size_t Arena::getUsed(void) {
+    return this->used;
+}
+
+size_t Arena::getSize(void) {
+    return this->size;
+}
+
+size_t Arena::getHighWaterMark(void) {
+    return this->highWaterMark;
+}
+
+word Arena::getFailures(void) {
+    return this->failures;
+}
+
+void Arena::report(Print *out, const char *label) {
+    out->print(label);
+    out->print(F(": "));
+    out->print((unsigned long) this->used);
+    out->print(F("/"));
+    out->print((unsigned long) this->size);
+    out->print(F(" bytes, high water mark "));
+    out->print((unsigned long) this->highWaterMark);
+    out->print(F(", failed allocations "));
+    out->println((unsigned long) this->failures);
+}
+
+Arena *Arena::framework(void) {
+    // built on first use, so components declared as globals in any
+    //  file can allocate from it while being constructed
+    static byte buffer[GAUGE_ARENA_SIZE];
+    static Arena arena(buffer, GAUGE_ARENA_SIZE);
+    return &arena;
+}
@@ -0,0 +1,61 @@
+#ifndef ARENA_H
+ #define ARENA_H
+
+#include <new>
+#include "Arduino.h"
+
+// room for the objects the framework builds for itself (sweeps, strategies,
+//  buffers), to change it pass -DGAUGE_ARENA_SIZE=... in the build flags
+#ifndef GAUGE_ARENA_SIZE
+ #if defined(ESP8266) || defined(ESP32)
+  #define GAUGE_ARENA_SIZE 2048
+ #else
+  #define GAUGE_ARENA_SIZE 192
+ #endif
+#endif
+
+/**
+ * Arena
+ * 
+ * Hands out memory from a fixed buffer, never from the heap. Nothing is
+ *  freed individually: objects live as long as the gauge does, so the
+ *  heap can't fragment no matter how long the gauge runs
+ * 
+ * The high water mark is the most the arena was ever filled, resets
+ *  included, and failed allocations are counted, so an undersized
+ *  arena can be spotted from the serial console
+ */
+class Arena {
+protected:
+    byte *buffer;
+    size_t size;
+    size_t used = 0;
+    size_t highWaterMark = 0;
+    word failures = 0;
+public:
+    static const size_t ALIGNMENT = sizeof(void*);
+    Arena(byte *buffer, size_t size);
+    void *allocate(size_t bytes);
+    void reset(void);
+    size_t getUsed(void);
+    size_t getSize(void);
+    size_t getHighWaterMark(void);
+    word getFailures(void);
+    void report(Print *out, const char *label);
+
+    /**
+     * The arena the framework allocates its own objects from
+     */
+    static Arena *framework(void);
+
+    /**
+     * Builds a T in the arena, returns NULL if there's no room left
+     */
+    template <typename T, typename... Args>
+    T *make(Args... args) {
+        void *slot = this->allocate(sizeof(T));
+        return slot == NULL ? NULL : new (slot) T(args...);
+    }
+};
+
+#endif
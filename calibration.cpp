@@ -0,0 +1,122 @@
+#include "calibration.h"
+#include "arena.h"
+
+CalibrationCurve::CalibrationCurve(const CalibrationPoint *points, byte count) {
+    this->points = points;
+    this->count = count;
+    this->compile();
+}
+
+bool CalibrationCurve::compile(void) {
+    this->valid = false;
+    if (this->count < 2) {
+        return false;
+    }
+    if (this->slopes == NULL) {
+        this->slopes = (long*) Arena::framework()->allocate((this->count - 1) * sizeof(long));
+        if (this->slopes == NULL) {
+            return false;
+        }
+    }
+
+    this->step = this->points[1].raw - this->points[0].raw;
+    for (byte i = 0; i < this->count - 1; i++) {
+        long rawDiff = (long) this->points[i + 1].raw - this->points[i].raw;
+        long valueDiff = (long) this->points[i + 1].value - this->points[i].value;
+        if (rawDiff <= 0 || valueDiff > 32767 || valueDiff < -32767) {
+            return false;
+        }
+        this->slopes[i] = (long) (((int64_t) valueDiff << 16) / rawDiff);
+        if (rawDiff != this->step) {
+            this->step = 0;
+        }
+    }
+    this->valid = true;
+    return true;
+}
+
+bool CalibrationCurve::isValid(void) {
+    return this->valid;
+}
+
+byte CalibrationCurve::findSegment(int raw) {
+    byte last = this->count - 2;
+
+    // evenly spaced table, straight to the segment
+    if (this->step > 0) {
+        int segment = (raw - this->points[0].raw) / this->step;
+        return segment > last ? last : segment;
+    }
+
+    byte low = 0;
+    byte high = last;
+    while (low < high) {
+        byte middle = (low + high + 1) / 2;
+        if (this->points[middle].raw <= raw) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+int CalibrationCurve::lookup(int raw) {
+    if (!this->valid) {
+        return 0;
+    }
+    if (raw <= this->points[0].raw) {
+        return this->points[0].value;
+    }
+    if (raw >= this->points[this->count - 1].raw) {
+        return this->points[this->count - 1].value;
+    }
+
+    byte segment = this->findSegment(raw);
+    long offset = (long) (raw - this->points[segment].raw) * this->slopes[segment];
+    return this->points[segment].value + (int) ((offset + 32768) >> 16);
+}
+
+
+
+CalibratedSensor::CalibratedSensor(
+    char pin,
+    CalibrationCurve *curve,
+    const char *unitName,
+    byte divisor
+    ) : AnalogSensor(pin) {
+    this->curve = curve;
+    this->unitName = unitName;
+    this->divisor = divisor;
+}
+
+void CalibratedSensor::tick(void) {
+    if (!this->curve->isValid()) {
+        return;
+    }
+    this->read();
+    this->value = this->curve->lookup(this->measurement);
+}
+
+void CalibratedSensor::init(void) {}
+
+int CalibratedSensor::raw(void) {
+    return this->value;
+}
+
+void CalibratedSensor::formatTo(char *buffer) {
+    if (!this->curve->isValid()) {
+        strcpy(buffer, "  ---");
+        return;
+    }
+    float adjusted = (float) this->value / this->divisor;
+    dtostrf(adjusted, 5, 1, buffer);
+}
+
+const char *CalibratedSensor::unit(void) {
+    return this->unitName;
+}
+
+bool CalibratedSensor::isReady(void) {
+    return this->curve->isValid();
+}
@@ -0,0 +1,71 @@
+#ifndef CALIBRATION_H
+ #define CALIBRATION_H
+
+#include "gauge_fw.h"
+#include "datasource.h"
+#include "Arduino.h"
+
+/**
+ * A point of a calibration table: the value read at a given raw level
+ */
+struct CalibrationPoint {
+    int raw;
+    int value;
+};
+
+
+/**
+ * Piecewise linear calibration curve
+ * 
+ * The table is compiled once into per-segment slopes (16 bits fixed
+ *  point), so a lookup is a segment search, a multiply and a shift. When
+ *  the points are evenly spaced the segment is found with a division,
+ *  otherwise with a binary search. Raw values outside the table are
+ *  clamped to its first/last point. An invalid curve looks everything
+ *  up as 0, never as the raw value passed through
+ * 
+ * Points must be sorted by raw level, with no repeated raw levels, and
+ *  consecutive values can't be further apart than 32767
+ */
+class CalibrationCurve {
+protected:
+    const CalibrationPoint *points;
+    byte count;
+    long *slopes = NULL;
+    int step = 0;
+    bool valid = false;
+    byte findSegment(int raw);
+public:
+    CalibrationCurve(const CalibrationPoint *points, byte count);
+    bool compile(void);
+    bool isValid(void);
+    int lookup(int raw);
+};
+
+
+/**
+ * Analog sensor whose readings go through a calibration curve, for
+ *  non linear senders like thermistors or fuel level floats
+ * 
+ * raw() is the calibrated value, format() divides it by 'divisor'. The
+ *  sensor isn't ready while its curve isn't valid (a bad table, or no
+ *  room in the framework arena to compile it): it's then never sampled,
+ *  raw() stays 0 and format() shows dashes instead of a number
+ */
+class CalibratedSensor : public AnalogSensor {
+protected:
+    CalibrationCurve *curve;
+    const char *unitName;
+    byte divisor;
+    int value = 0;
+public:
+    CalibratedSensor(char pin, CalibrationCurve *curve, const char *unitName = "", byte divisor = 1);
+    void tick(void);
+    void init(void);
+    int raw(void);
+    void formatTo(char *buffer);
+    const char *unit(void);
+    bool isReady(void);
+};
+
+#endif
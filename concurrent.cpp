@@ -0,0 +1,165 @@
+#include "concurrent.h"
+
+SnapshotSource::SnapshotSource(DataSource *source) : DataSource() {
+    this->source = source;
+    this->buffers[0].raw = 0;
+    this->buffers[0].sampledAt = 0;
+    this->buffers[0].formatted[0] = '\0';
+    this->buffers[1] = this->buffers[0];
+}
+
+void SnapshotSource::publish(void) {
+    byte back = this->front ^ 1;
+    this->buffers[back].raw = this->source->raw();
+    this->buffers[back].sampledAt = this->source->getSampledAt();
+    this->source->formatTo(this->buffers[back].formatted);
+
+    // make sure the buffer is written before it becomes the front one
+    __sync_synchronize();
+    this->front = back;
+    this->sequence++;
+    __sync_synchronize();
+}
+
+SourceSnapshot SnapshotSource::load(void) {
+    SourceSnapshot snapshot;
+    unsigned long sequence;
+    do {
+        sequence = this->sequence;
+        __sync_synchronize();
+        snapshot = this->buffers[this->front];
+        __sync_synchronize();
+    // a publish while copying may have been writing over our buffer, retry
+    } while (sequence != this->sequence);
+    return snapshot;
+}
+
+void SnapshotSource::init(void) {}
+
+void SnapshotSource::read(void) {}
+
+int SnapshotSource::raw(void) {
+    return this->load().raw;
+}
+
+const char *SnapshotSource::unit(void) {
+    // units never change, so it is safe to read them from any core
+    return this->source->unit();
+}
+
+void SnapshotSource::formatTo(char *buffer) {
+    SourceSnapshot snapshot = this->load();
+    memcpy(buffer, snapshot.formatted, DataSource::FORMAT_SIZE);
+}
+
+byte SnapshotSource::getSourceDepth(void) {
+    return this->source->getSourceDepth();
+}
+
+unsigned long SnapshotSource::getSampledAt(void) {
+    return this->load().sampledAt;
+}
+
+
+
+DualCoreGauge::DualCoreGauge(void) {}
+
+bool DualCoreGauge::add(GaugeComponent *component) {
+    if (component->getDepth() == GaugeComponent::DEPTH_SINK) {
+        return this->display.add(component);
+    }
+    return this->sampling.add(component);
+}
+
+bool DualCoreGauge::share(SnapshotSource *snapshot) {
+    if (this->snapshotCount == CompositeGauge::MAX_COMPONENTS) {
+        return false;
+    }
+    this->snapshots[this->snapshotCount++] = snapshot;
+    return true;
+}
+
+void DualCoreGauge::init(void) {
+#ifdef ESP32
+    xTaskCreatePinnedToCore(&DualCoreGauge::samplingTask, "sampling", 4096, this, 1, NULL, SAMPLING_CORE);
+    xTaskCreatePinnedToCore(&DualCoreGauge::displayTask, "display", 4096, this, 1, NULL, DISPLAY_CORE);
+#elif !defined(ARDUINO)
+    this->running = true;
+    pthread_create(&this->threads[0], NULL, &DualCoreGauge::samplingThread, this);
+    pthread_create(&this->threads[1], NULL, &DualCoreGauge::displayThread, this);
+#endif
+}
+
+void DualCoreGauge::tickSampling(void) {
+    this->sampling.tick();
+    for (byte i = 0; i < this->snapshotCount; i++) {
+        this->snapshots[i]->publish();
+    }
+    this->samplingTicks++;
+}
+
+void DualCoreGauge::tickDisplay(void) {
+    this->display.tick();
+    this->displayTicks++;
+}
+
+void DualCoreGauge::tick(void) {
+#ifdef ESP32
+    // both stages have their own task already, end the one calling loop()
+    vTaskDelete(NULL);
+#else
+ #ifndef ARDUINO
+    // the threads run the stages already
+    if (this->running) {
+        return;
+    }
+ #endif
+    this->tickSampling();
+    this->tickDisplay();
+#endif
+}
+
+#ifdef ESP32
+void DualCoreGauge::samplingTask(void *gauge) {
+    for (;;) {
+        ((DualCoreGauge*) gauge)->tickSampling();
+        // let the idle task of this core run, or the watchdog bites
+        vTaskDelay(1);
+    }
+}
+
+void DualCoreGauge::displayTask(void *gauge) {
+    for (;;) {
+        ((DualCoreGauge*) gauge)->tickDisplay();
+        vTaskDelay(1);
+    }
+}
+#endif
+
+#if !defined(ESP32) && !defined(ARDUINO)
+void *DualCoreGauge::samplingThread(void *gauge) {
+    while (((DualCoreGauge*) gauge)->running) {
+        ((DualCoreGauge*) gauge)->tickSampling();
+    }
+    return NULL;
+}
+
+void *DualCoreGauge::displayThread(void *gauge) {
+    while (((DualCoreGauge*) gauge)->running) {
+        ((DualCoreGauge*) gauge)->tickDisplay();
+    }
+    return NULL;
+}
+
+/**
+ * Stops both threads, tick() runs the stages in sequence afterwards
+ */
+void DualCoreGauge::stop(void) {
+    if (!this->running) {
+        return;
+    }
+    this->running = false;
+    pthread_join(this->threads[0], NULL);
+    pthread_join(this->threads[1], NULL);
+}
+#endif
@@ -0,0 +1,104 @@
+#ifndef CONCURRENT_H
+ #define CONCURRENT_H
+
+#if defined(ESP8266) || defined(ESP32)
+ #include <vector>
+#else
+ #include <ArduinoSTL>
+#endif
+#ifdef ESP32
+ #include <freertos/FreeRTOS.h>
+ #include <freertos/task.h>
+#elif !defined(ARDUINO)
+ #include <pthread.h>
+#endif
+#include "gauge_fw.h"
+#include "datasource.h"
+#include "Arduino.h"
+
+using namespace std;
+
+/**
+ * A copy of the state of a DataSource at a given tick
+ */
+struct SourceSnapshot {
+    int raw;
+    unsigned long sampledAt;
+    char formatted[DataSource::FORMAT_SIZE];
+};
+
+
+/**
+ * DataSource that displays read instead of the sensor itself, when
+ *  sampling and displaying run on different cores
+ * 
+ * The sampling side publish()es into the back buffer and flips it to the
+ *  front, the display side reads the front buffer and retries if a
+ *  publish happened meanwhile; neither side ever blocks on the other
+ */
+class SnapshotSource : public DataSource {
+protected:
+    DataSource *source;
+    SourceSnapshot buffers[2];
+    volatile byte front = 0;
+    volatile unsigned long sequence = 0;
+    SourceSnapshot load(void);
+public:
+    SnapshotSource(DataSource *source);
+    void publish(void);
+    void init(void);
+    void read(void);
+    int raw(void);
+    const char *unit(void);
+    void formatTo(char *buffer);
+    byte getSourceDepth(void);
+    unsigned long getSampledAt(void);
+};
+
+
+/**
+ * DualCoreGauge
+ * 
+ * Splits the components in two stages: sources (sampling) and sinks
+ *  (LEDs, screens), exchanging values through SnapshotSources.
+ *  On ESP32 each stage runs in its own task pinned to its own core, and
+ *  on a PC in its own thread (until stop()), elsewhere tick() runs both
+ *  stages one after the other
+ * 
+ * On ESP32 tick() never returns: it ends the task loop() runs in, so that
+ *  task doesn't keep spinning on the display core for nothing
+ */
+class DualCoreGauge {
+    CompositeGauge sampling;
+    CompositeGauge display;
+    SnapshotSource *snapshots[CompositeGauge::MAX_COMPONENTS];
+    byte snapshotCount = 0;
+#ifdef ESP32
+    static void samplingTask(void *gauge);
+    static void displayTask(void *gauge);
+#elif !defined(ARDUINO)
+    pthread_t threads[2];
+    volatile bool running = false;
+    static void *samplingThread(void *gauge);
+    static void *displayThread(void *gauge);
+#endif
+public:
+#ifdef ESP32
+    static const byte SAMPLING_CORE = 0;
+    static const byte DISPLAY_CORE = 1;
+#endif
+    volatile unsigned long samplingTicks = 0;
+    volatile unsigned long displayTicks = 0;
+    DualCoreGauge(void);
+    bool add(GaugeComponent *component);
+    bool share(SnapshotSource *snapshot);
+    void init(void);
+    void tickSampling(void);
+    void tickDisplay(void);
+    void tick(void);
+#if !defined(ESP32) && !defined(ARDUINO)
+    void stop(void);
+#endif
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "datasource.h"
+#include "arena.h"
 using namespace std;
 
 int readAnalog(char location) {
@@ -15,12 +16,39 @@ void DataSource::setReader(readerFunc *reader) {
     this->reader = reader;
 };
 
-AnalogSensor::AnalogSensor(char location) : DataSource() {
+String DataSource::format(void) {
+    char charBuf[FORMAT_SIZE];
+    this->formatTo(charBuf);
+    return String(charBuf);
+};
+
+byte DataSource::getSourceDepth(void) {
+    return 0;
+};
+
+unsigned long DataSource::getSampledAt(void) {
+    return this->sampledAt;
+};
+
+SourceComponent::SourceComponent() : DataSource(), GaugeComponent() {}
+
+byte SourceComponent::getDepth(void) {
+    return this->getSourceDepth();
+}
+
+DataSource *SourceComponent::getSource(byte index) {
+    return index == 0 ? this : NULL;
+}
+
+
+
+AnalogSensor::AnalogSensor(char location) : SourceComponent() {
     this->location = location;
 }
 
 void AnalogSensor::read() {
     measurement = (*reader)(this->location);
+    sampledAt = micros();
 }
 
 int AnalogSensor::raw(void) {
@@ -32,7 +60,7 @@ TestSensor::TestSensor(
     word minLevel,
     word maxLevel,
     byte speed
-    ) : DataSource(), GaugeComponent() {
+    ) : SourceComponent() {
     this->minLevel = minLevel;
     this->maxLevel = maxLevel;
     this->speed = speed;
@@ -55,19 +83,18 @@ void TestSensor::tick(void) {
     } else {
         this->measurement -= this->speed;
     }
+    this->sampledAt = micros();
 }
 
 
 void TestSensor::init(void) {}
 
-String TestSensor::format(void) {
+void TestSensor::formatTo(char *buffer) {
     float adjusted = ((float) measurement / 10 - 50);
-    char charBuf[10];
-    String formatted = dtostrf(adjusted, 5, 1, charBuf);
-    return formatted;
+    dtostrf(adjusted, 5, 1, buffer);
 };
 
-String TestSensor::unit(void) {
+const char *TestSensor::unit(void) {
     return "unit";
 };
 
@@ -77,20 +104,150 @@ int TestSensor::raw(void) {
 
 
 
-MPXSensor::MPXSensor(char pin, char adcValueOffset, float error) :
-  AnalogSensor(pin), GaugeComponent() {
+DerivedSource::DerivedSource(
+    vector<DataSource*> *inputs,
+    combinerFunc combiner,
+    const char *unitName,
+    byte divisor
+    ) : SourceComponent() {
+    this->inputs = inputs;
+    this->combiner = combiner;
+    this->unitName = unitName;
+    this->divisor = divisor;
+    this->values = (int*) Arena::framework()->allocate(inputs->size() * sizeof(int));
+}
+
+void DerivedSource::read(void) {
+    // the framework arena was too small to hold the input values
+    if (this->values == NULL) {
+        return;
+    }
+
+    // the result is as old as its oldest input
+    unsigned long now = micros();
+    this->sampledAt = now;
+    for (byte i = 0; i < this->inputs->size(); i++) {
+        DataSource *input = (*this->inputs)[i];
+        this->values[i] = input->raw();
+        if (now - input->getSampledAt() > now - this->sampledAt) {
+            this->sampledAt = input->getSampledAt();
+        }
+    }
+    this->measurement = this->combiner(this->values, this->inputs->size());
+}
+
+void DerivedSource::tick(void) {
+    this->read();
+}
+
+void DerivedSource::init(void) {}
+
+void DerivedSource::formatTo(char *buffer) {
+    float adjusted = (float) this->measurement / this->divisor;
+    dtostrf(adjusted, 5, 1, buffer);
+}
+
+const char *DerivedSource::unit(void) {
+    return this->unitName;
+}
+
+int DerivedSource::raw(void) {
+    return this->measurement;
+}
+
+byte DerivedSource::getSourceDepth(void) {
+    if (this->depthKnown) {
+        return this->depth;
+    }
+    // asked again while working it out: one of the inputs leads back here
+    if (this->resolving) {
+        return DEPTH_CYCLE;
+    }
+
+    this->resolving = true;
+    byte depth = 0;
+    for (vector<DataSource*>::iterator it = this->inputs->begin(); it != this->inputs->end(); ++it) {
+        byte inputDepth = (*it)->getSourceDepth();
+        // in a cycle, or nested too deep to tell from one
+        if (inputDepth >= DEPTH_CYCLE - 1) {
+            depth = DEPTH_CYCLE;
+            break;
+        }
+        if (inputDepth >= depth) {
+            depth = inputDepth + 1;
+        }
+    }
+    this->resolving = false;
+    this->depth = depth;
+    this->depthKnown = true;
+    return depth;
+}
+
+bool DerivedSource::isReady(void) {
+    return this->values != NULL && this->getSourceDepth() != DEPTH_CYCLE;
+}
+
+
+
+ReplaySensor::ReplaySensor(
+    const word *samples,
+    word count,
+    unsigned long interval
+    ) : SourceComponent() {
+    this->samples = samples;
+    this->count = count;
+    this->interval = interval;
+}
+
+void ReplaySensor::read(void) {}
+
+void ReplaySensor::tick(void) {
+    unsigned long now = micros();
+    if (this->sampledAt != 0 && now - this->sampledAt < this->interval) {
+        return;
+    }
+    this->measurement = this->samples[this->position];
+    this->position = (this->position + 1) % this->count;
+    this->sampledAt = now;
+}
+
+void ReplaySensor::init(void) {}
+
+void ReplaySensor::formatTo(char *buffer) {
+    float adjusted = (float) measurement / 10;
+    dtostrf(adjusted, 5, 1, buffer);
+}
+
+const char *ReplaySensor::unit(void) {
+    return "unit";
+}
+
+int ReplaySensor::raw(void) {
+    return measurement;
+}
+
+
+
+MPXSensor::MPXSensor(char pin, int8_t adcValueOffset, float error) :
+  AnalogSensor(pin) {
     this->error = error;
     this->adcValueOffset = adcValueOffset;
 }
 
+int MPXSensor::raw(void) {
+    return this->bank != NULL ? this->bank->raw[this->slot] : this->measurement;
+}
+
+unsigned long MPXSensor::getSampledAt(void) {
+    return this->bank != NULL ? this->bank->sampledAt : this->sampledAt;
+}
+
+int MPXSensor::getKpaAbs(void) {
+    return this->bank != NULL ? this->bank->kpaAbs[this->slot] : this->kpaAbs;
+}
+
 float MPXSensor::toKpaAbs() {
-    float localMeasurement = (
-        ((float) this->measurement - this->adcValueOffset) /
-        ((float) AnalogSensor::V_RESOLUTION_INV) /
-        ((float) this->getMilliVoltPerKpa() / 1000) +
-        this->getKpaOffset()) *
-        (1 + this->error);
-    return localMeasurement;
+    return (float) this->getKpaAbs() / 10;
 }
 
 float MPXSensor::toKpaRel() {
@@ -108,30 +265,117 @@ float MPXSensor::toPsiRel() {
         ((float) PressureSensor::ONE_ATM_PSI / 10) /
         ((float) PressureSensor::ONE_ATM_KPA / 10);
 }
-void MPXSensor::init(void) {}
+void MPXSensor::init(void) {
+    // kpa = ((adc - offset) / V_RESOLUTION_INV / (mV_PER_KPA / 1000) + KPA_OFFSET) * (1 + error)
+    //  the gain is in tenths of kpa per adc count, 16 bits fixed point
+    float scale = 1 + this->error;
+    this->conversionGain = (long) (
+        10000.0 * scale /
+        ((float) AnalogSensor::V_RESOLUTION_INV * this->getMilliVoltPerKpa()) *
+        65536 + 0.5);
+    this->conversionBase = (int) (10.0 * this->getKpaOffset() * scale + 0.5);
+
+    if (this->zeroSamples > 0) {
+        this->calibrateZero(this->zeroSamples);
+    }
+}
 
+/**
+ * Calibrate the ADC offset at the next init(), from the average of
+ *  'samples' readings; only when the engine is off at power up
+ */
+void MPXSensor::setAutoZero(byte samples) {
+    this->zeroSamples = samples;
+}
 
+/**
+ * Sets the ADC offset so that what the sensor reads right now is
+ *  its resting pressure (atmospheric for absolute sensors)
+ * 
+ * Returns false if the offset needed is more than +-127 counts, the
+ *  offset is then left at the limit and isZeroClamped() tells so
+ *  (a wrong sensor type, or the engine running, most likely)
+ */
+bool MPXSensor::calibrateZero(byte samples) {
+    if (samples == 0 || this->conversionGain == 0) {
+        return false;
+    }
+
+    long total = 0;
+    for (byte i = 0; i < samples; i++) {
+        this->read();
+        total += this->measurement;
+    }
+    word average = (total + samples / 2) / samples;
+
+    // pressure with no offset, and the offset (in adc counts) that takes it to resting
+    int offset = 0;
+    int kpaAbs;
+    convert(&average, &offset, &this->conversionGain, &this->conversionBase, &kpaAbs, 1);
+    // a multiply, shifting a negative difference left is undefined
+    long difference = (long) (kpaAbs - this->getRestingKpa()) * 65536L;
+    long counts = (difference + (difference < 0 ? -this->conversionGain : this->conversionGain) / 2) / this->conversionGain;
+
+    this->zeroClamped = counts > 127 || counts < -127;
+    this->adcValueOffset = counts > 127 ? 127 : (counts < -127 ? -127 : counts);
+    if (this->bank != NULL) {
+        this->bank->offsets[this->slot] = this->adcValueOffset;
+    }
+    return !this->zeroClamped;
+}
+
+bool MPXSensor::isZeroClamped(void) {
+    return this->zeroClamped;
+}
+
+int8_t MPXSensor::getAdcValueOffset(void) {
+    return this->adcValueOffset;
+}
+
+long MPXSensor::getConversionGain(void) {
+    return this->conversionGain;
+}
+
+int MPXSensor::getConversionBase(void) {
+    return this->conversionBase;
+}
 
-String MPXSensor::format(void) {
+void MPXSensor::convert(
+    const word *raw,
+    const int *offsets,
+    const long *gains,
+    const int *bases,
+    int *kpaAbs,
+    byte count
+    ) {
+    for (byte i = 0; i < count; i++) {
+        kpaAbs[i] = bases[i] + (((long) ((int) raw[i] - offsets[i]) * gains[i] + 32768) >> 16);
+    }
+}
+
+
+
+void MPXSensor::formatTo(char *buffer) {
     float level = toPsiRel();
-    char charBuf[10];
-    String formatted = dtostrf(level, 5, 1, charBuf);
-    return formatted;
+    dtostrf(level, 5, 1, buffer);
 }
 
-String MPXSensor::unit(void) {
+const char *MPXSensor::unit(void) {
     return "psi";
 }
 
 void MPXSensor::tick(void) {
     this->read();
+    word raw = this->measurement;
+    int offset = this->adcValueOffset;
+    convert(&raw, &offset, &this->conversionGain, &this->conversionBase, &this->kpaAbs, 1);
 }
 
 
 
 MPX4250Sensor::MPX4250Sensor(
     char pin,
-    byte adcValueOffset,
+    int8_t adcValueOffset,
     float error
     ) : MPXSensor(pin, adcValueOffset, error) {}
 
@@ -146,7 +390,7 @@ char MPX4250Sensor::getKpaOffset() {
 
 MPX5500Sensor::MPX5500Sensor(
     char pin,
-    byte adcValueOffset,
+    int8_t adcValueOffset,
     float error
     ) : MPXSensor(pin, adcValueOffset, error) {}
 
@@ -154,9 +398,72 @@ char MPX5500Sensor::getMilliVoltPerKpa() {
     return this->mV_PER_KPA;
 }
 
-String MPX5500Sensor::format(void) {
+int MPX5500Sensor::getRestingKpa() {
+    // differential, reads zero at rest
+    return 0;
+}
+
+void MPX5500Sensor::formatTo(char *buffer) {
     float level = toPsiAbs();
-    char charBuf[10];
-    String formatted = dtostrf(level, 5, 1, charBuf);
-    return formatted;
+    dtostrf(level, 5, 1, buffer);
+}
+
+
+
+MPXSensorBank::MPXSensorBank(MPXSensor **sensors, byte count) : GaugeComponent() {
+    this->sensors = sensors;
+    this->count = count;
+
+    Arena *arena = Arena::framework();
+    this->readers = (readerFunc*) arena->allocate(count * sizeof(readerFunc));
+    this->locations = (char*) arena->allocate(count);
+    this->raw = (word*) arena->allocate(count * sizeof(word));
+    this->offsets = (int*) arena->allocate(count * sizeof(int));
+    this->gains = (long*) arena->allocate(count * sizeof(long));
+    this->bases = (int*) arena->allocate(count * sizeof(int));
+    this->kpaAbs = (int*) arena->allocate(count * sizeof(int));
+    if (!this->isReady()) {
+        // the framework arena was too small, the bank will do nothing
+        this->count = 0;
+    }
+}
+
+void MPXSensorBank::init(void) {
+    for (byte i = 0; i < this->count; i++) {
+        MPXSensor *sensor = this->sensors[i];
+        sensor->init();
+        this->readers[i] = *sensor->reader;
+        this->locations[i] = sensor->location;
+        this->raw[i] = sensor->measurement;
+        this->offsets[i] = sensor->adcValueOffset;
+        this->gains[i] = sensor->conversionGain;
+        this->bases[i] = sensor->conversionBase;
+        this->kpaAbs[i] = sensor->kpaAbs;
+        // from now on calibrateZero() updates offsets[i] too
+        sensor->bank = this;
+        sensor->slot = i;
+    }
+}
+
+void MPXSensorBank::tick(void) {
+    for (byte i = 0; i < this->count; i++) {
+        this->raw[i] = this->readers[i](this->locations[i]);
+    }
+    this->sampledAt = micros();
+
+    MPXSensor::convert(this->raw, this->offsets, this->gains, this->bases, this->kpaAbs, this->count);
+}
+
+byte MPXSensorBank::getDepth(void) {
+    return 0;
+}
+
+DataSource *MPXSensorBank::getSource(byte index) {
+    return index < this->count ? this->sensors[index] : NULL;
+}
+
+bool MPXSensorBank::isReady(void) {
+    return this->readers != NULL && this->locations != NULL &&
+        this->raw != NULL && this->offsets != NULL && this->gains != NULL &&
+        this->bases != NULL && this->kpaAbs != NULL;
 }
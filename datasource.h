@@ -1,7 +1,7 @@
 #ifndef DATASOURCE_H
  #define DATASOURCE_H
         
-#ifdef ESP8266  || defined(ESP32)
+#if defined(ESP8266) || defined(ESP32)
  #include <vector>
 #else
  #include <ArduinoSTL>
@@ -27,21 +27,41 @@ int readAnalog(char location);
 class DataSource {
 protected:
     readerFunc *reader;
+    unsigned long sampledAt = 0;
 public:
+    static const byte FORMAT_SIZE = 10;
     DataSource();
     virtual void init(void) = 0;
     virtual void read(void) = 0;
     virtual int raw(void) = 0;
-    virtual String unit(void) = 0;
-    virtual String format(void) = 0;
+    virtual const char *unit(void) = 0;
+    virtual void formatTo(char *buffer) = 0;
+    virtual String format(void);
+    virtual byte getSourceDepth(void);
+    virtual unsigned long getSampledAt(void);
     void setReader(readerFunc *reader);
 };
 
 
+/**
+ * A DataSource that is also ticked by the gauge (sensors)
+ * 
+ * Sits in the gauge at the depth of the source, so it's always ticked
+ *  before whatever reads it; base any sensor on this rather than on
+ *  DataSource and GaugeComponent, or it will be taken for a display
+ */
+class SourceComponent : public DataSource, public GaugeComponent {
+public:
+    SourceComponent();
+    byte getDepth(void);
+    DataSource *getSource(byte index);
+};
+
+
 /**
  * Abstract Analog Sensor 
  */
-class AnalogSensor : public DataSource {
+class AnalogSensor : public SourceComponent {
 protected:
     char location;
     word measurement;
@@ -76,7 +96,7 @@ public:
  *  
  *  Useful to simulate sensors with software only ;)
  */
-class TestSensor : public DataSource, public GaugeComponent {
+class TestSensor : public SourceComponent {
     boolean direction = 1; // 1 up; 0 down;
     word measurement = 0;
     word minLevel;
@@ -87,34 +107,146 @@ public:
     void read();
     void tick(void);
     void init(void);
-    String format(void);
-    String unit(void);
+    void formatTo(char *buffer);
+    const char *unit(void);
+    int raw(void);
+};
+
+
+/**
+ * The combiner function for derived data sources,
+ *  receives the raw values of the inputs in the order they were given
+ */
+typedef int (*combinerFunc)(int *values, byte count);
+
+/**
+ * DataSource computed from other DataSources (eg. boost minus backpressure)
+ * 
+ * The inputs are combined once per tick and the result cached, so every
+ *  display, sweep or alert reading it gets the same memoized value.
+ *  Its depth is one level deeper than its deepest input, so the gauge
+ *  always ticks it after the sources it depends on; it's worked out the
+ *  first time it's asked for (when added to the gauge), so the inputs
+ *  have to be in place by then. Inputs that lead back to the source
+ *  itself make it DEPTH_CYCLE, and not ready
+ */
+class DerivedSource : public SourceComponent {
+protected:
+    vector<DataSource*> *inputs;
+    int *values;
+    combinerFunc combiner;
+    const char *unitName;
+    byte divisor;
+    int measurement = 0;
+    byte depth = 0;
+    bool depthKnown = false;
+    bool resolving = false;
+public:
+    static const byte DEPTH_CYCLE = 254;
+    DerivedSource(
+      vector<DataSource*> *inputs,
+      combinerFunc combiner,
+      const char *unitName = "",
+      byte divisor = 1
+    );
+    void read(void);
+    void tick(void);
+    void init(void);
+    void formatTo(char *buffer);
+    const char *unit(void);
+    int raw(void);
+    byte getSourceDepth(void);
+    bool isReady(void);
+};
+
+
+/**
+ * Sensor that plays back a recording of raw samples, one every
+ *  'interval' microseconds, then starts over
+ * 
+ *  Useful to feed the same input to the gauge over and over, like when
+ *  measuring latencies
+ */
+class ReplaySensor : public SourceComponent {
+    const word *samples;
+    word count;
+    word position = 0;
+    unsigned long interval;
+    word measurement = 0;
+public:
+    ReplaySensor(const word *samples, word count, unsigned long interval);
+    void read(void);
+    void tick(void);
+    void init(void);
+    void formatTo(char *buffer);
+    const char *unit(void);
     int raw(void);
 };
 
 
+class MPXSensorBank;
+
 /**
  * Base class for MPX{xxxx} family of pressure sensors
  */
-class MPXSensor : public PressureSensor, public AnalogSensor, public GaugeComponent {
+class MPXSensor : public PressureSensor, public AnalogSensor {
 protected:
-    char adcValueOffset = 0;
+    int8_t adcValueOffset = 0;
     float error = 0;
+    // fixed point conversion, set up at init(), divide pressures by 10
+    long conversionGain = 0;
+    int conversionBase = 0;
+    int kpaAbs = 0;
+    byte zeroSamples = 0;
+    bool zeroClamped = false;
+    // set by the MPXSensorBank that samples and converts for this sensor
+    MPXSensorBank *bank = NULL;
+    byte slot = 0;
+    int getKpaAbs(void);
     float toKpaAbs();
     float toKpaRel();
     float toPsiAbs();
     float toPsiRel();
     
 public:
-    MPXSensor(char pin, char adcValueOffset = 0, float error = 0);
-    String format(void);
-    String unit(void);
+    MPXSensor(char pin, int8_t adcValueOffset = 0, float error = 0);
+    int raw(void);
+    unsigned long getSampledAt(void);
+    void formatTo(char *buffer);
+    const char *unit(void);
     void tick(void);
     void init(void);
     virtual char getMilliVoltPerKpa() = 0;
     virtual char getKpaOffset() {
         return 0;
     };
+    // what the sensor reads with the engine off (divide by 10)
+    virtual int getRestingKpa() {
+        return PressureSensor::ONE_ATM_KPA;
+    };
+    void setAutoZero(byte samples = 16);
+    bool calibrateZero(byte samples);
+    bool isZeroClamped(void);
+    int8_t getAdcValueOffset(void);
+    long getConversionGain(void);
+    int getConversionBase(void);
+
+    /**
+     * Converts raw ADC counts to absolute pressure (divide by 10), for
+     *  'count' sensors at once; every parameter is one array per field
+     *  (structure of arrays), so the loop has no calls and no floats
+     *  and the compiler can vectorize it where the target allows
+     */
+    static void convert(
+      const word *raw,
+      const int *offsets,
+      const long *gains,
+      const int *bases,
+      int *kpaAbs,
+      byte count
+    );
+
+    friend class MPXSensorBank;
 };
 
 
@@ -134,7 +266,7 @@ public:
     static const byte KPA_OFFSET_AT_ZERO_V = 20;
 #endif
     
-    MPX4250Sensor(char pin, byte adcValueOffset = 0, float error = 0.015);
+    MPX4250Sensor(char pin, int8_t adcValueOffset = 0, float error = 0.015);
     char getMilliVoltPerKpa();
     char getKpaOffset();
 };
@@ -153,10 +285,45 @@ public:
 #else
     static const byte mV_PER_KPA = 9;
 #endif
-    MPX5500Sensor(char pin, byte adcValueOffset = 0, float error = 0.0025);
+    MPX5500Sensor(char pin, int8_t adcValueOffset = 0, float error = 0.0025);
 
     char getMilliVoltPerKpa();
-    String format(void);
+    int getRestingKpa();
+    void formatTo(char *buffer);
+};
+
+
+/**
+ * A group of MPX sensors sampled and converted together
+ * 
+ * Add the bank to the gauge instead of the sensors: each tick it reads
+ *  the ADC of every sensor straight into one array, then converts all of
+ *  them in a single MPXSensor::convert() pass. Readers, pins and offsets
+ *  are taken from the sensors at init() (and calibrateZero()), so a tick
+ *  makes no calls through them; the sensors keep working as DataSources
+ *  for sweeps and screens, reading their values from the bank
+ */
+class MPXSensorBank : public GaugeComponent {
+protected:
+    MPXSensor **sensors;
+    byte count;
+    readerFunc *readers;
+    char *locations;
+    unsigned long sampledAt = 0;
+    word *raw;
+    int *offsets;
+    long *gains;
+    int *bases;
+    int *kpaAbs;
+public:
+    MPXSensorBank(MPXSensor **sensors, byte count);
+    void init(void);
+    void tick(void);
+    byte getDepth(void);
+    DataSource *getSource(byte index);
+    bool isReady(void);
+
+    friend class MPXSensor;
 };
 
 #endif
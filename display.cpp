@@ -1,4 +1,5 @@
 #include "display.h"
+#include "arena.h"
 #include <Wire.h>
 
 int IlluminationStrategy::getFirstLedKeyDiff(int previousLedCount, int ledCount) {
@@ -36,19 +37,270 @@ int* LevelOnlyIlluminationStrategy::getIlluminationColor(int currentLed, int lev
   }
 
   if (currentLed >= (level - radio) && currentLed <= (level + radio)) {
-    int adjustedIColor[] = {baseColor[0] / 3, baseColor[1] / 3, baseColor[2] / 3};
+    // kept in the strategy, a local array would be gone by the time it's read
+    this->adjustedColor[0] = baseColor[0] / 3;
+    this->adjustedColor[1] = baseColor[1] / 3;
+    this->adjustedColor[2] = baseColor[2] / 3;
+    return this->adjustedColor;
+  }
+
+  return blankColor;
+}
+
+
+
+NeoPixelLEDOutput::NeoPixelLEDOutput(Adafruit_NeoPixel *strip) : LEDOutput() {
+  this->strip = strip;
+}
+
+void NeoPixelLEDOutput::begin(void) {
+  this->strip->begin();
+}
+
+void NeoPixelLEDOutput::setLed(int led, int red, int green, int blue) {
+  this->strip->setPixelColor(led, red, green, blue);
+}
+
+void NeoPixelLEDOutput::show(void) {
+  this->strip->show();
+}
+
 
-    // for some reason this needs to be here
-    //  to return the right color for all instances
-    delay(0);
 
-    return adjustedIColor;
+MultiStripLEDOutput::MultiStripLEDOutput(vector<Adafruit_NeoPixel*> *strips) : LEDOutput() {
+  this->strips = strips;
+  this->dirty = (bool*) Arena::framework()->allocate(strips->size() * sizeof(bool));
+  for (byte i = 0; this->dirty != NULL && i < strips->size(); i++) {
+    this->dirty[i] = true;
   }
+}
 
-  return blankColor;
+void MultiStripLEDOutput::begin(void) {
+  for (vector<Adafruit_NeoPixel*>::iterator it = this->strips->begin(); it != this->strips->end(); ++it) {
+    (*it)->begin();
+  }
+}
+
+/**
+ * What getPixelColor() gives back for a color channel set to `value`: with
+ *  the brightness set the strip keeps the colors scaled down and loses the
+ *  low bits, so it never reads back what was written
+ */
+static uint8_t readBack(uint8_t value, uint16_t brightness) {
+  return ((((uint16_t) value * brightness) >> 8) << 8) / brightness;
+}
+
+void MultiStripLEDOutput::setLed(int led, int red, int green, int blue) {
+  // find the strip holding the LED, and the LED index within that strip
+  for (byte i = 0; i < this->strips->size(); i++) {
+    Adafruit_NeoPixel *strip = (*this->strips)[i];
+    if (led >= strip->numPixels()) {
+      led -= strip->numPixels();
+      continue;
+    }
+
+    // only flag the strip for refresh if the color actually changed
+    uint16_t brightness = strip->getBrightness() + 1;
+    uint32_t color = Adafruit_NeoPixel::Color(
+      readBack(red, brightness),
+      readBack(green, brightness),
+      readBack(blue, brightness)
+    );
+    if (strip->getPixelColor(led) != color) {
+      strip->setPixelColor(led, red, green, blue);
+      if (this->dirty != NULL) {
+        this->dirty[i] = true;
+      }
+    }
+    return;
+  }
+}
+
+void MultiStripLEDOutput::show(void) {
+  // no room for the dirty flags, refresh everything every time
+  if (this->dirty == NULL) {
+    for (byte i = 0; i < this->strips->size(); i++) {
+      (*this->strips)[i]->show();
+    }
+    return;
+  }
+
+  for (byte i = 0; i < this->strips->size(); i++) {
+    if (this->dirty[i]) {
+      (*this->strips)[i]->show();
+      this->dirty[i] = false;
+    }
+  }
+}
+
+
+
+#if defined(ESP32) || !defined(ARDUINO)
+#ifdef ESP32
+// RMT ticks at 40MHz (clk_div 2), 25ns each
+static const rmt_item32_t WS2812_ZERO = {{{ 16, 1, 34, 0 }}};
+static const rmt_item32_t WS2812_ONE = {{{ 32, 1, 18, 0 }}};
+
+/**
+ * Turns the GRB bytes into RMT items while the strip is being sent
+ */
+static void IRAM_ATTR ws2812Translate(
+  const void *src,
+  rmt_item32_t *dest,
+  size_t srcSize,
+  size_t wanted,
+  size_t *translated,
+  size_t *items
+) {
+  size_t size = 0;
+  size_t num = 0;
+  const byte *bytes = (const byte*) src;
+  while (size < srcSize && num + 8 <= wanted) {
+    for (byte bit = 0x80; bit != 0; bit >>= 1) {
+      dest[num++] = (bytes[size] & bit) ? WS2812_ONE : WS2812_ZERO;
+    }
+    size++;
+  }
+  *translated = size;
+  *items = num;
+}
+#endif
+
+ParallelLEDOutput::ParallelLEDOutput(const byte *pins, const word *ledCounts, byte count) : LEDOutput() {
+  this->pins = pins;
+  this->ledCounts = ledCounts;
+  this->count = count > MAX_STRIPS ? MAX_STRIPS : count;
+  this->pixels = (byte**) Arena::framework()->allocate(this->count * sizeof(byte*));
+#ifndef ESP32
+  this->busyUntil = (unsigned long*) Arena::framework()->allocate(this->count * sizeof(unsigned long));
+#endif
+  for (byte i = 0; this->pixels != NULL && i < this->count; i++) {
+    this->pixels[i] = (byte*) Arena::framework()->allocate(ledCounts[i] * 3);
+    if (this->pixels[i] != NULL) {
+      memset(this->pixels[i], 0, ledCounts[i] * 3);
+    }
+  }
 }
 
- 
+void ParallelLEDOutput::begin(void) {
+  this->ready = 0;
+  for (byte i = 0; this->pixels != NULL && i < this->count; i++) {
+    if (this->pixels[i] == NULL) {
+      continue;
+    }
+#ifdef ESP32
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t) this->pins[i], (rmt_channel_t) i);
+    config.clk_div = 2;
+    if (rmt_config(&config) != ESP_OK
+      || rmt_driver_install(config.channel, 0, 0) != ESP_OK
+      || rmt_translator_init(config.channel, ws2812Translate) != ESP_OK) {
+      continue;
+    }
+#else
+    if (this->busyUntil == NULL) {
+      continue;
+    }
+    this->busyUntil[i] = micros();
+#endif
+    this->ready |= 1 << i;
+  }
+}
+
+/**
+ * Whether every strip got its buffer from the framework arena
+ */
+bool ParallelLEDOutput::isReady(void) {
+#ifndef ESP32
+  if (this->busyUntil == NULL) {
+    return false;
+  }
+#endif
+  for (byte i = 0; this->pixels != NULL && i < this->count; i++) {
+    if (this->pixels[i] == NULL) {
+      return false;
+    }
+  }
+  return this->pixels != NULL;
+}
+
+/**
+ * How many strips got their channel and their buffer, the LEDs of
+ *  the rest are dropped
+ */
+byte ParallelLEDOutput::getReadyStrips(void) {
+  byte strips = 0;
+  for (byte i = 0; i < this->count; i++) {
+    strips += (this->ready >> i) & 1;
+  }
+  return strips;
+}
+
+/**
+ * The colors a strip sends (3 bytes per LED, GRB), NULL if it has no buffer
+ */
+const byte *ParallelLEDOutput::getPixels(byte strip) {
+  return this->pixels != NULL && strip < this->count ? this->pixels[strip] : NULL;
+}
+
+void ParallelLEDOutput::setLed(int led, int red, int green, int blue) {
+  for (byte i = 0; i < this->count; i++) {
+    if (led >= (int) this->ledCounts[i]) {
+      led -= this->ledCounts[i];
+      continue;
+    }
+    if (this->ready & (1 << i)) {
+      byte *pixel = this->pixels[i] + led * 3;
+      pixel[0] = green;
+      pixel[1] = red;
+      pixel[2] = blue;
+    }
+    return;
+  }
+}
+
+void ParallelLEDOutput::startStrip(byte strip) {
+#ifdef ESP32
+  rmt_write_sample((rmt_channel_t) strip, this->pixels[strip], this->ledCounts[strip] * 3, false);
+#else
+  this->busyUntil[strip] = micros() + this->ledCounts[strip] * 30UL;
+#endif
+}
+
+void ParallelLEDOutput::waitStrip(byte strip) {
+#ifdef ESP32
+  rmt_wait_tx_done((rmt_channel_t) strip, portMAX_DELAY);
+#else
+  while ((long) (this->busyUntil[strip] - micros()) > 0) {}
+#endif
+}
+
+void ParallelLEDOutput::show(void) {
+  // the previous frame has to be latched before the next one starts
+  while (micros() - this->shownAt < LATCH_MICROS) {}
+
+  for (byte i = 0; i < this->count; i++) {
+    if (this->ready & (1 << i)) {
+      this->startStrip(i);
+    }
+  }
+  for (byte i = 0; i < this->count; i++) {
+    if (this->ready & (1 << i)) {
+      this->waitStrip(i);
+    }
+  }
+  this->shownAt = micros();
+}
+#endif
+
+
+
+/**
+ * Where the elements of a vector are, NULL for an empty one
+ */
+template <typename T>
+static T *elements(vector<T> *values) {
+  return values->empty() ? NULL : &(*values)[0];
+}
 
 IndAddrLEDStripSweep::IndAddrLEDStripSweep(
   DataSource *dataSource,
@@ -61,6 +313,34 @@ IndAddrLEDStripSweep::IndAddrLEDStripSweep(
   vector<int> *sweepLeds,
   vector<int> *alertLeds,
   IlluminationStrategy *strategy
+) : IndAddrLEDStripSweep(
+  dataSource,
+  minLevel,
+  maxLevel,
+  alertLevel,
+  baseColor,
+  alertColor,
+  blankColor,
+  elements(sweepLeds),
+  sweepLeds->size(),
+  elements(alertLeds),
+  alertLeds->size(),
+  strategy
+) {}
+
+IndAddrLEDStripSweep::IndAddrLEDStripSweep(
+  DataSource *dataSource,
+  int minLevel,
+  int maxLevel,
+  int alertLevel,
+  int baseColor[3],
+  int alertColor[3],
+  int blankColor[3],
+  const int *sweepLeds,
+  word sweepLedCount,
+  const int *alertLeds,
+  word alertLedCount,
+  IlluminationStrategy *strategy
 ) {
     this->dataSource = dataSource;
     this->minLevel = minLevel;
@@ -72,30 +352,25 @@ IndAddrLEDStripSweep::IndAddrLEDStripSweep(
     this->blankColor = blankColor;
 
     this->sweepLeds = sweepLeds;
+    this->sweepLedCount = sweepLedCount;
     this->alertLeds = alertLeds;
+    this->alertLedCount = alertLedCount;
     this->strategy = strategy;
 }
 
-void IndAddrLEDStripSweep::update(Adafruit_NeoPixel *ledStrip) {
+void IndAddrLEDStripSweep::update(LEDOutput *output) {
   // calculate how many leds should be lit, by calculating the ranges
   int relativeLevel = dataSource->raw() - this->minLevel;
   int sweepRange = this->maxLevel - this->minLevel;
   float percentileLevel = relativeLevel / (float)sweepRange;
-  int howManyLeds = percentileLevel * this->sweepLeds->size() - 1;
+  int howManyLeds = percentileLevel * this->sweepLedCount - 1;
 
-  int ledKey = 0;
   //  get initial modified LED key, so that we skip the whole strip and only update the modified LEDs
   int startingLedKey = this->strategy->getFirstLedKeyDiff(this->previousLedCount, howManyLeds);
   this->previousLedCount = howManyLeds;
-  for (vector<int>::iterator it = this->sweepLeds->begin(); it != this->sweepLeds->end(); ++it) {
-    if (ledKey < startingLedKey) {
-      ledKey++;
-      continue;
-    }
+  for (int ledKey = startingLedKey > 0 ? startingLedKey : 0; ledKey < this->sweepLedCount; ledKey++) {
     int *color = this->strategy->getIlluminationColor(ledKey, howManyLeds, this->baseColor, this->blankColor);        
-    ledStrip->setPixelColor(*it, color[0], color[1], color[2]);
-    
-    ledKey++;
+    output->setLed(this->sweepLeds[ledKey], color[0], color[1], color[2]);
   }
 
   // check if new reading triggered alert
@@ -104,8 +379,8 @@ void IndAddrLEDStripSweep::update(Adafruit_NeoPixel *ledStrip) {
    this->currentlyAlerting = true;
 
    // set all alerting leds to the alert color
-   for (vector<int>::iterator it = this->alertLeds->begin(); it != this->alertLeds->end(); ++it) {
-      ledStrip->setPixelColor(*it, alertColor[0], alertColor[1], alertColor[2]);
+   for (word i = 0; i < this->alertLedCount; i++) {
+      output->setLed(this->alertLeds[i], alertColor[0], alertColor[1], alertColor[2]);
    }
   } else {
     // alert threshold not crossed,
@@ -115,8 +390,8 @@ void IndAddrLEDStripSweep::update(Adafruit_NeoPixel *ledStrip) {
       this->currentlyAlerting = false;
 
       // turn off all alert leds
-      for (vector<int>::iterator it = this->alertLeds->begin(); it != this->alertLeds->end(); ++it) {
-        ledStrip->setPixelColor(*it, 0, 0, 0);
+      for (word i = 0; i < this->alertLedCount; i++) {
+        output->setLed(this->alertLeds[i], 0, 0, 0);
       }
     }
   }
@@ -126,6 +401,10 @@ bool IndAddrLEDStripSweep::isAlert() {
   return dataSource->raw() > this->alertLevel;
 }
 
+unsigned long IndAddrLEDStripSweep::getSampledAt() {
+  return dataSource->getSampledAt();
+}
+
 
 
 SingleSweepLEDStrip::SingleSweepLEDStrip(
@@ -140,9 +419,11 @@ SingleSweepLEDStrip::SingleSweepLEDStrip(
   int alertColor[3],
   vector<int> *sweepLeds,
   vector<int> *alertLeds
-  ) : GaugeComponent(), Adafruit_NeoPixel(totalLeds, dataPin, NEO_GRB + NEO_KHZ800)
+  ) : GaugeComponent(), Adafruit_NeoPixel(totalLeds, dataPin, NEO_GRB + NEO_KHZ800), output(this)
    {
-    this->sweep = new IndAddrLEDStripSweep(
+    Arena *arena = Arena::framework();
+    IlluminationStrategy *strategy = arena->make<FullSweepIlluminationStrategy>();
+    this->sweep = strategy == NULL ? NULL : arena->make<IndAddrLEDStripSweep>(
       dataSource,
       minLevel,
       maxLevel,
@@ -152,7 +433,7 @@ SingleSweepLEDStrip::SingleSweepLEDStrip(
       alertColor,
       sweepLeds,
       alertLeds,
-      new FullSweepIlluminationStrategy()
+      strategy
     );
 }
 
@@ -162,8 +443,17 @@ void SingleSweepLEDStrip::init(void) {
 }
     
 void SingleSweepLEDStrip::tick(void) {
-  this->sweep->update(this);
+  // the framework arena was too small to build the sweep
+  if (this->sweep == NULL) {
+    return;
+  }
+  this->sweep->update(&this->output);
   show();
+  trace(0, this->sweep->getSampledAt());
+}
+
+bool SingleSweepLEDStrip::isReady(void) {
+  return this->sweep != NULL;
 }
 
 
@@ -173,7 +463,7 @@ DualSweepLEDStrip::DualSweepLEDStrip(
   IndAddrLEDStripSweep *sweep2,
   uint16_t dataPin,
   uint8_t totalLeds
-) : GaugeComponent(), Adafruit_NeoPixel(totalLeds, dataPin, NEO_GRB + NEO_KHZ800)
+) : GaugeComponent(), Adafruit_NeoPixel(totalLeds, dataPin, NEO_GRB + NEO_KHZ800), output(this)
    {
     this->sweep1 = sweep1;
     this->sweep2 = sweep2;
@@ -185,9 +475,47 @@ void DualSweepLEDStrip::init(void) {
 }
     
 void DualSweepLEDStrip::tick(void) {
-    this->sweep1->update(this);
-    this->sweep2->update(this);
+    this->sweep1->update(&this->output);
+    this->sweep2->update(&this->output);
     show();
+    trace(0, this->sweep1->getSampledAt());
+    trace(1, this->sweep2->getSampledAt());
+}
+
+
+
+MultiSweepLEDStrip::MultiSweepLEDStrip(
+  vector<IndAddrLEDStripSweep*> *sweeps,
+  LEDOutput *output
+) : MultiSweepLEDStrip(elements(sweeps), sweeps->size(), output) {}
+
+MultiSweepLEDStrip::MultiSweepLEDStrip(
+  IndAddrLEDStripSweep **sweeps,
+  byte sweepCount,
+  LEDOutput *output
+) : GaugeComponent() {
+    this->sweeps = sweeps;
+    this->sweepCount = sweepCount;
+    this->output = output;
+}
+
+void MultiSweepLEDStrip::init(void) {
+    this->output->begin();
+    this->output->show();
+}
+
+void MultiSweepLEDStrip::tick(void) {
+    for (byte i = 0; i < this->sweepCount; i++) {
+        this->sweeps[i]->update(this->output);
+    }
+    this->output->show();
+    for (byte i = 0; i < this->sweepCount; i++) {
+        trace(i, this->sweeps[i]->getSampledAt());
+    }
+}
+
+bool MultiSweepLEDStrip::isReady(void) {
+    return this->output->isReady();
 }
 
 
@@ -243,10 +571,13 @@ void DualDataSourceScreen::init(void){
 }
     
 void DualDataSourceScreen::tick(void) {
+  char formatted[DataSource::FORMAT_SIZE];
+
   set2X();
   setCol(this->measurementX);
   setRow(this->topDataSourceY);
-  print(this->topDataSource->format());
+  this->topDataSource->formatTo(formatted);
+  print(formatted);
   setFont(font5x7);
   set1X();
   setRow(this->topDataSourceY + 2);
@@ -256,13 +587,16 @@ void DualDataSourceScreen::tick(void) {
   set2X();
   setCol(this->measurementX);
   setRow(this->bottomDataSourceY);
-  print(this->bottomDataSource->format());
+  this->bottomDataSource->formatTo(formatted);
+  print(formatted);
   setFont(font5x7);
   set1X();
   setRow(this->bottomDataSourceY + 2);
   print(this->bottomDataSource->unit());
   setFont(X11fixed7x14B);
   home();
+  trace(0, this->topDataSource->getSampledAt());
+  trace(1, this->bottomDataSource->getSampledAt());
 }
 
 
@@ -288,9 +622,12 @@ void SingleDataSourceScreen::init(void){
 }
     
 void SingleDataSourceScreen::tick(void) {
+  char formatted[DataSource::FORMAT_SIZE];
+
   setCol(this->measurementX);
   setRow(this->measurementY);
-  print(this->dataSource->format());
+  this->dataSource->formatTo(formatted);
+  print(formatted);
   setFont(font5x7);
   set1X();
   setRow(this->unitY);
@@ -298,4 +635,5 @@ void SingleDataSourceScreen::tick(void) {
   setFont(X11fixed7x14B);
   set2X();
   home();
+  trace(0, this->dataSource->getSampledAt());
 }
@@ -1,7 +1,7 @@
 #ifndef DISPLAY_H
  #define DISPLAY_H
 
-#ifdef ESP8266 || defined(ESP32)
+#if defined(ESP8266) || defined(ESP32)
  #include <vector>
 #else
  #include <ArduinoSTL>
@@ -10,8 +10,12 @@
 #include <SSD1306Ascii.h>
 #include <SSD1306AsciiWire.h>
 #include <Adafruit_NeoPixel.h>
+#ifdef ESP32
+ #include <driver/rmt.h>
+#endif
 #include "gauge_fw.h"
 #include "datasource.h"
+#include "latency.h"
 
 using namespace std;
 
@@ -55,6 +59,8 @@ class InverseFullSweepIlluminationStrategy : public IlluminationStrategy {
 class LevelOnlyIlluminationStrategy : public IlluminationStrategy {
   protected:
     int radio;
+    // the dimmed color around the level, returned to the caller
+    int adjustedColor[3];
   public:
     LevelOnlyIlluminationStrategy(int radio);
     
@@ -63,12 +69,112 @@ class LevelOnlyIlluminationStrategy : public IlluminationStrategy {
  
 
 
+/**
+ * LED Output Interface
+ * 
+ * Where sweeps write their LEDs to; the LED indexes are global to the
+ *  output, so a single sweep can span several physical strips
+ */
+class LEDOutput {
+  public:
+    virtual void begin(void) = 0;
+    virtual void setLed(int led, int red, int green, int blue) = 0;
+    virtual void show(void) = 0;
+    // false when it couldn't get its buffers from the framework arena
+    virtual bool isReady(void) {
+      return true;
+    };
+};
+
+
+/**
+ * Output to a single NeoPixel strip
+ */
+class NeoPixelLEDOutput : public LEDOutput {
+  protected:
+    Adafruit_NeoPixel *strip;
+  public:
+    NeoPixelLEDOutput(Adafruit_NeoPixel *strip);
+    void begin(void);
+    void setLed(int led, int red, int green, int blue);
+    void show(void);
+};
+
+
+/**
+ * Output to several NeoPixel strips, each one on its own data pin
+ * 
+ * LEDs are numbered across the strips in the order given, (the first LED
+ *  of the second strip comes right after the last one of the first strip).
+ *  The strips are still refreshed one after the other, but the ones where
+ *  no LED changed color are skipped
+ */
+class MultiStripLEDOutput : public LEDOutput {
+  protected:
+    vector<Adafruit_NeoPixel*> *strips;
+    bool *dirty;
+  public:
+    MultiStripLEDOutput(vector<Adafruit_NeoPixel*> *strips);
+    void begin(void);
+    void setLed(int led, int red, int green, int blue);
+    void show(void);
+};
+
+
+#if defined(ESP32) || !defined(ARDUINO)
+/**
+ * Output to several WS2812 strips, each one on its own data pin, all of
+ *  them sent at the same time
+ * 
+ * LEDs are numbered across the strips like in MultiStripLEDOutput, but
+ *  show() starts every strip and then waits for all of them, so it takes
+ *  as long as the longest strip instead of the sum of all of them: split
+ *  the LEDs over more pins and the refresh time stays the same
+ * 
+ * On ESP32 each strip gets an RMT channel (up to 8 on the ESP32, 4 on the
+ *  S3, 2 on the C3) and the colors are kept as 3 bytes per LED in the
+ *  framework arena. It uses the legacy RMT driver of arduino-esp32 2.x;
+ *  don't mix it with Adafruit_NeoPixel on 3.x. On a PC it models the wire
+ *  time (30us per LED) so benchmarks can be run against the serial outputs
+ */
+class ParallelLEDOutput : public LEDOutput {
+  protected:
+    const byte *pins;
+    const word *ledCounts;
+    byte count;
+    byte **pixels;
+    byte ready = 0;
+    unsigned long shownAt = 0;
+#ifndef ESP32
+    unsigned long *busyUntil;
+#endif
+    void startStrip(byte strip);
+    void waitStrip(byte strip);
+  public:
+    static const byte MAX_STRIPS = 8;
+    // WS2812 needs the line low this long to latch the colors
+    static const word LATCH_MICROS = 300;
+    ParallelLEDOutput(const byte *pins, const word *ledCounts, byte count);
+    void begin(void);
+    void setLed(int led, int red, int green, int blue);
+    void show(void);
+    bool isReady(void);
+    byte getReadyStrips(void);
+    const byte *getPixels(byte strip);
+};
+#endif
+
+
 /**
  * Individually Addressable LED Strip SWEEP
  * 
  * Component that defines and operates the sweep of an LED Strip
  *  upon update call, the instance of the LED Strip that needs to
  *  contain this sweep needs to be passed
+ * 
+ * The LED indexes come as vectors or as plain arrays (what GaugeConfig
+ *  builds in its arena), either way they are kept where they are: don't
+ *  resize the vectors once the sweep is built
  */
 class IndAddrLEDStripSweep {
   protected:
@@ -77,8 +183,10 @@ class IndAddrLEDStripSweep {
     IlluminationStrategy *strategy;
     int previousLedCount = 0;
   public:
-    vector<int> *sweepLeds;
-    vector<int> *alertLeds;
+    const int *sweepLeds;
+    word sweepLedCount;
+    const int *alertLeds;
+    word alertLedCount;
     int minLevel = 0;
     int maxLevel = 1;
     int alertLevel = 2;
@@ -97,20 +205,37 @@ class IndAddrLEDStripSweep {
       vector<int> *alertLeds,
       IlluminationStrategy *strategy
       );
+    IndAddrLEDStripSweep(
+      DataSource *dataSource,
+      int minLevel,
+      int maxLevel,
+      int alertLevel,
+      int baseColor[3],
+      int alertColor[3],
+      int blankColor[3],
+      const int *sweepLeds,
+      word sweepLedCount,
+      const int *alertLeds,
+      word alertLedCount,
+      IlluminationStrategy *strategy
+      );
 
-    void update(Adafruit_NeoPixel *ledStrip);
+    void update(LEDOutput *output);
 
     bool isAlert();
+
+    unsigned long getSampledAt();
 };
 
 
 /**
  * Single Sweep, single sensor LED Strip (aka LED Ring)
  */
-class SingleSweepLEDStrip : public GaugeComponent, public Adafruit_NeoPixel {
+class SingleSweepLEDStrip : public GaugeComponent, public Adafruit_NeoPixel, public LatencyTraced {
   protected:
     DataSource *dataSource;
     IndAddrLEDStripSweep *sweep;
+    NeoPixelLEDOutput output;
   public: 
     SingleSweepLEDStrip(
       DataSource *dataSource,
@@ -129,15 +254,18 @@ class SingleSweepLEDStrip : public GaugeComponent, public Adafruit_NeoPixel {
     void init(void);
     
     void tick(void);
+
+    bool isReady(void);
 };
 
 /**
  * Dual Sweep, Dual Sensor LED Strip (aka LED Ring)
  */
-class DualSweepLEDStrip : public GaugeComponent, public Adafruit_NeoPixel {
+class DualSweepLEDStrip : public GaugeComponent, public Adafruit_NeoPixel, public LatencyTraced {
   protected:
     IndAddrLEDStripSweep *sweep1;
     IndAddrLEDStripSweep *sweep2;
+    NeoPixelLEDOutput output;
   public: 
     DualSweepLEDStrip(
       IndAddrLEDStripSweep *sweep1,
@@ -150,6 +278,34 @@ class DualSweepLEDStrip : public GaugeComponent, public Adafruit_NeoPixel {
     void tick(void);
 };
 
+/**
+ * Any number of sweeps (and sensors) over any LED output
+ * 
+ * Pair it with a MultiStripLEDOutput to drive several strips
+ *  of hundreds of LEDs from a single component. Like the LEDs of a
+ *  sweep, the sweeps are kept where they are, vector or array
+ */
+class MultiSweepLEDStrip : public GaugeComponent, public LatencyTraced {
+  protected:
+    IndAddrLEDStripSweep **sweeps;
+    byte sweepCount;
+    LEDOutput *output;
+  public:
+    MultiSweepLEDStrip(
+      vector<IndAddrLEDStripSweep*> *sweeps,
+      LEDOutput *output
+      );
+    MultiSweepLEDStrip(
+      IndAddrLEDStripSweep **sweeps,
+      byte sweepCount,
+      LEDOutput *output
+      );
+
+    void init(void);
+    void tick(void);
+    bool isReady(void);
+};
+
 
 /**
  * I2C Screen abstract class
@@ -180,7 +336,7 @@ public:
 /**
  * An I2C OLED Screen with dual measurement, one on top, and anotheer on the bottom
  */
-class DualDataSourceScreen : public AsciiOledScreen, public GaugeComponent {
+class DualDataSourceScreen : public AsciiOledScreen, public GaugeComponent, public LatencyTraced {
     DataSource *topDataSource;
     DataSource *bottomDataSource;
     byte measurementX;
@@ -207,7 +363,7 @@ class DualDataSourceScreen : public AsciiOledScreen, public GaugeComponent {
  *  
  * A DataSource aware screen, with positionable measurement and unit
  */
-class SingleDataSourceScreen : public AsciiOledScreen, public GaugeComponent {
+class SingleDataSourceScreen : public AsciiOledScreen, public GaugeComponent, public LatencyTraced {
     DataSource *dataSource;
     byte measurementX;
     byte measurementY;
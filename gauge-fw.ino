@@ -97,11 +97,20 @@ void setup() {
       
       // ===================================
 
+    // tick every 5ms, every 100ms once the sensors on display
+    //  didn't move in 200 ticks (1 second); the test sensor never
+    //  stops sweeping, so with it on display the gauge stays awake
+    gauge.watch(&sensor, 0);
+    gauge.watch(&sensor2, 2);
+    gauge.setIdleMode(5000, 100000, 200);
+
   // =========================================
 }
 
 void loop() {
   // tick, like in a clock, not like the insect
   gauge.tick();
-  delay(0);
+
+  // sleep until the next tick is due
+  gauge.idle();
 }
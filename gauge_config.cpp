@@ -0,0 +1,472 @@
+#include "gauge_config.h"
+
+ConfigReader::ConfigReader(word length) {
+    this->length = length;
+}
+
+byte ConfigReader::next(void) {
+    if (this->position >= this->length) {
+        this->overrun = true;
+        return 0;
+    }
+    byte value = this->readAt(this->position++);
+    this->checksum += value;
+    return value;
+}
+
+word ConfigReader::nextWord(void) {
+    word low = this->next();
+    return low | ((word) this->next() << 8);
+}
+
+void ConfigReader::rewind(void) {
+    this->position = 0;
+    this->checksum = 0;
+    this->overrun = false;
+}
+
+
+MemoryConfigReader::MemoryConfigReader(const byte *data, word length) : ConfigReader(length) {
+    this->data = data;
+}
+
+byte MemoryConfigReader::readAt(word position) {
+    return this->data[position];
+}
+
+
+FlashConfigReader::FlashConfigReader(const byte *data, word length) : ConfigReader(length) {
+    this->data = data;
+}
+
+byte FlashConfigReader::readAt(word position) {
+    return pgm_read_byte(this->data + position);
+}
+
+
+EEPROMConfigReader::EEPROMConfigReader(word start, word length) : ConfigReader(length) {
+    this->start = start;
+}
+
+byte EEPROMConfigReader::readAt(word position) {
+#if defined(ESP8266) || defined(ESP32)
+    // the emulated EEPROM needs to be copied to RAM before the first read
+    if (!this->started) {
+        EEPROM.begin(this->start + this->length);
+        this->started = true;
+    }
+#endif
+    return EEPROM.read(this->start + position);
+}
+
+
+
+GaugeConfig::GaugeConfig(Arena *arena) {
+    this->arena = arena;
+}
+
+bool GaugeConfig::fail(byte error) {
+    this->error = error;
+    return false;
+}
+
+bool GaugeConfig::validate(ConfigReader *reader) {
+    // the dry run counts sources and sweeps on the way, the counts of what
+    //  an earlier load() built go with its arrays, so they are kept
+    byte sourceCount = this->sourceCount;
+    byte sweepCount = this->sweepCount;
+    bool valid = this->parse(reader, NULL);
+    this->sourceCount = sourceCount;
+    this->sweepCount = sweepCount;
+    return valid;
+}
+
+bool GaugeConfig::load(ConfigReader *reader, CompositeGauge *gauge) {
+    unsigned long startedAt = micros();
+    // a dry run first, so nothing gets built from a bad description
+    if (!this->validate(reader)) {
+        return false;
+    }
+    if (this->arenaNeeded > this->arena->getSize() - this->arena->getUsed()) {
+        return this->fail(ERROR_ARENA_FULL);
+    }
+    if (this->componentsNeeded > CompositeGauge::MAX_COMPONENTS - gauge->getComponentCount()) {
+        return this->fail(ERROR_GAUGE_FULL);
+    }
+
+    reader->rewind();
+    bool loaded = this->parse(reader, gauge);
+    this->loadMicros = micros() - startedAt;
+    return loaded;
+}
+
+/**
+ * Counts an allocation the description will need from the arena, with
+ *  the worst case padding
+ */
+void GaugeConfig::need(size_t bytes) {
+    this->arenaNeeded += bytes + Arena::ALIGNMENT - 1;
+}
+
+/**
+ * Adds a component to the gauge, or fails the load when the gauge is full
+ *  or the component couldn't get its memory
+ */
+bool GaugeConfig::add(CompositeGauge *gauge, GaugeComponent *component) {
+    if (!component->isReady()) {
+        return this->fail(ERROR_ARENA_FULL);
+    }
+    return gauge->add(component) ? true : this->fail(ERROR_GAUGE_FULL);
+}
+
+DataSource *GaugeConfig::getSource(byte index) {
+    return index < this->sourceCount && this->sources != NULL ? this->sources[index] : NULL;
+}
+
+byte GaugeConfig::getSourceCount(void) {
+    return this->sourceCount;
+}
+
+/**
+ * Walks the whole description, building the components as it goes
+ *  unless there is no gauge to put them in (validation only)
+ */
+bool GaugeConfig::parse(ConfigReader *reader, CompositeGauge *gauge) {
+    this->error = ERROR_NONE;
+    this->arenaNeeded = 0;
+    this->componentsNeeded = 0;
+    if (reader->next() != MAGIC_0 || reader->next() != MAGIC_1 || reader->next() != VERSION) {
+        return this->fail(ERROR_HEADER);
+    }
+
+    if (!this->parseSensors(reader, gauge) ||
+        !this->parseSweeps(reader, gauge) ||
+        !this->parseStrips(reader, gauge) ||
+        !this->parseScreens(reader, gauge)) {
+        // running out of bytes makes anything look wrong, report the cause
+        return reader->overrun ? this->fail(ERROR_TRUNCATED) : false;
+    }
+
+    byte checksum = reader->checksum;
+    if (reader->next() != checksum) {
+        return this->fail(ERROR_CHECKSUM);
+    }
+    return reader->overrun ? this->fail(ERROR_TRUNCATED) : true;
+}
+
+bool GaugeConfig::parseSensors(ConfigReader *reader, CompositeGauge *gauge) {
+    bool build = gauge != NULL;
+    this->sourceCount = reader->next();
+    this->need(this->sourceCount * sizeof(DataSource*));
+    if (build) {
+        this->sources = (DataSource**) this->arena->allocate(this->sourceCount * sizeof(DataSource*));
+        if (this->sources == NULL && this->sourceCount > 0) {
+            return this->fail(ERROR_ARENA_FULL);
+        }
+        for (byte i = 0; i < this->sourceCount; i++) {
+            this->sources[i] = NULL;
+        }
+    }
+
+    for (byte i = 0; i < this->sourceCount; i++) {
+        byte type = reader->next();
+        if (type == SENSOR_TEST) {
+            word minLevel = reader->nextWord();
+            word maxLevel = reader->nextWord();
+            byte speed = reader->next();
+            this->need(sizeof(TestSensor));
+            this->componentsNeeded++;
+            if (!build) {
+                continue;
+            }
+            TestSensor *sensor = this->arena->make<TestSensor>(minLevel, maxLevel, speed);
+            if (sensor == NULL) {
+                return this->fail(ERROR_ARENA_FULL);
+            }
+            this->sources[i] = sensor;
+            if (!this->add(gauge, sensor)) {
+                return false;
+            }
+        } else if (type == SENSOR_MPX4250 || type == SENSOR_MPX5500) {
+            char pin = reader->next();
+            int8_t adcValueOffset = (int8_t) reader->next();
+            float error = (float) reader->nextWord() / 10000;
+            this->need(type == SENSOR_MPX4250 ? sizeof(MPX4250Sensor) : sizeof(MPX5500Sensor));
+            this->componentsNeeded++;
+            if (!build) {
+                continue;
+            }
+            MPXSensor *sensor;
+            if (type == SENSOR_MPX4250) {
+                sensor = this->arena->make<MPX4250Sensor>(pin, adcValueOffset, error);
+            } else {
+                sensor = this->arena->make<MPX5500Sensor>(pin, adcValueOffset, error);
+            }
+            if (sensor == NULL) {
+                return this->fail(ERROR_ARENA_FULL);
+            }
+            this->sources[i] = sensor;
+            if (!this->add(gauge, sensor)) {
+                return false;
+            }
+        } else {
+            return this->fail(ERROR_TYPE);
+        }
+    }
+    return reader->overrun ? this->fail(ERROR_TRUNCATED) : true;
+}
+
+int *GaugeConfig::parseColor(ConfigReader *reader, bool build) {
+    byte red = reader->next();
+    byte green = reader->next();
+    byte blue = reader->next();
+    this->need(3 * sizeof(int));
+    if (!build) {
+        return NULL;
+    }
+    int *color = (int*) this->arena->allocate(3 * sizeof(int));
+    if (color != NULL) {
+        color[0] = red;
+        color[1] = green;
+        color[2] = blue;
+    }
+    return color;
+}
+
+/**
+ * Reads a list of LEDs into the arena, 'count' gets its length and
+ *  'ledsNeeded' grows to cover the highest LED in it
+ */
+int *GaugeConfig::parseLeds(ConfigReader *reader, bool build, byte *count, word *ledsNeeded) {
+    *count = reader->next();
+    this->need(*count * sizeof(int));
+    int *leds = build ? (int*) this->arena->allocate(*count * sizeof(int)) : NULL;
+    for (byte i = 0; i < *count; i++) {
+        word led = reader->nextWord();
+        word needed = led == 0xFFFF ? led : led + 1;
+        if (needed > *ledsNeeded) {
+            *ledsNeeded = needed;
+        }
+        if (leds != NULL) {
+            leds[i] = led;
+        }
+    }
+    return leds;
+}
+
+IlluminationStrategy *GaugeConfig::parseStrategy(ConfigReader *reader, bool build) {
+    byte type = reader->next();
+    byte radio = reader->next();
+    if (type > STRATEGY_LEVEL_ONLY) {
+        this->fail(ERROR_TYPE);
+        return NULL;
+    }
+    if (type == STRATEGY_FULL_SWEEP) {
+        this->need(sizeof(FullSweepIlluminationStrategy));
+    } else if (type == STRATEGY_INVERSE_FULL_SWEEP) {
+        this->need(sizeof(InverseFullSweepIlluminationStrategy));
+    } else {
+        this->need(sizeof(LevelOnlyIlluminationStrategy));
+    }
+    if (!build) {
+        return NULL;
+    }
+
+    IlluminationStrategy *strategy;
+    if (type == STRATEGY_FULL_SWEEP) {
+        strategy = this->arena->make<FullSweepIlluminationStrategy>();
+    } else if (type == STRATEGY_INVERSE_FULL_SWEEP) {
+        strategy = this->arena->make<InverseFullSweepIlluminationStrategy>();
+    } else {
+        strategy = this->arena->make<LevelOnlyIlluminationStrategy>((int) radio);
+    }
+    if (strategy == NULL) {
+        this->fail(ERROR_ARENA_FULL);
+    }
+    return strategy;
+}
+
+bool GaugeConfig::parseSweeps(ConfigReader *reader, CompositeGauge *gauge) {
+    bool build = gauge != NULL;
+    this->sweepCount = reader->next();
+    if (this->sweepCount > MAX_SWEEPS) {
+        return this->fail(ERROR_TOO_MANY_SWEEPS);
+    }
+    this->need(this->sweepCount * sizeof(IndAddrLEDStripSweep*));
+    if (build) {
+        this->sweeps = (IndAddrLEDStripSweep**) this->arena->allocate(this->sweepCount * sizeof(IndAddrLEDStripSweep*));
+        if (this->sweeps == NULL && this->sweepCount > 0) {
+            return this->fail(ERROR_ARENA_FULL);
+        }
+    }
+
+    for (byte i = 0; i < this->sweepCount; i++) {
+        byte source = reader->next();
+        int minLevel = (int16_t) reader->nextWord();
+        int maxLevel = (int16_t) reader->nextWord();
+        int alertLevel = (int16_t) reader->nextWord();
+        int *baseColor = this->parseColor(reader, build);
+        int *alertColor = this->parseColor(reader, build);
+        int *blankColor = this->parseColor(reader, build);
+        IlluminationStrategy *strategy = this->parseStrategy(reader, build);
+        byte sweepLedCount;
+        byte alertLedCount;
+        word ledsNeeded = 0;
+        int *sweepLeds = this->parseLeds(reader, build, &sweepLedCount, &ledsNeeded);
+        int *alertLeds = this->parseLeds(reader, build, &alertLedCount, &ledsNeeded);
+        this->sweepLedsNeeded[i] = ledsNeeded;
+
+        if (this->error != ERROR_NONE) {
+            return false;
+        }
+        if (source >= this->sourceCount) {
+            return this->fail(ERROR_INDEX);
+        }
+        this->need(sizeof(IndAddrLEDStripSweep));
+        if (!build) {
+            continue;
+        }
+        if (baseColor == NULL || alertColor == NULL || blankColor == NULL || sweepLeds == NULL || alertLeds == NULL) {
+            return this->fail(ERROR_ARENA_FULL);
+        }
+
+        this->sweeps[i] = this->arena->make<IndAddrLEDStripSweep>(
+            this->sources[source],
+            minLevel,
+            maxLevel,
+            alertLevel,
+            baseColor,
+            alertColor,
+            blankColor,
+            sweepLeds,
+            sweepLedCount,
+            alertLeds,
+            alertLedCount,
+            strategy
+        );
+        if (this->sweeps[i] == NULL) {
+            return this->fail(ERROR_ARENA_FULL);
+        }
+    }
+    return reader->overrun ? this->fail(ERROR_TRUNCATED) : true;
+}
+
+bool GaugeConfig::parseStrips(ConfigReader *reader, CompositeGauge *gauge) {
+    bool build = gauge != NULL;
+    byte stripCount = reader->next();
+    for (byte i = 0; i < stripCount; i++) {
+        byte pin = reader->next();
+        word totalLeds = reader->nextWord();
+        byte count = reader->next();
+        this->need(count * sizeof(IndAddrLEDStripSweep*));
+        this->need(sizeof(Adafruit_NeoPixel));
+        this->need(sizeof(NeoPixelLEDOutput));
+        this->need(sizeof(MultiSweepLEDStrip));
+        this->componentsNeeded++;
+
+        IndAddrLEDStripSweep **stripSweeps = build ? (IndAddrLEDStripSweep**) this->arena->allocate(count * sizeof(IndAddrLEDStripSweep*)) : NULL;
+        if (build && stripSweeps == NULL) {
+            return this->fail(ERROR_ARENA_FULL);
+        }
+        for (byte j = 0; j < count; j++) {
+            byte sweep = reader->next();
+            if (sweep >= this->sweepCount) {
+                return this->fail(ERROR_INDEX);
+            }
+            if (this->sweepLedsNeeded[sweep] > totalLeds) {
+                return this->fail(ERROR_LED);
+            }
+            if (build) {
+                stripSweeps[j] = this->sweeps[sweep];
+            }
+        }
+        if (!build) {
+            continue;
+        }
+
+        Adafruit_NeoPixel *strip = this->arena->make<Adafruit_NeoPixel>(totalLeds, (uint16_t) pin, (neoPixelType) (NEO_GRB + NEO_KHZ800));
+        NeoPixelLEDOutput *output = strip == NULL ? NULL : this->arena->make<NeoPixelLEDOutput>(strip);
+        MultiSweepLEDStrip *component = output == NULL ? NULL : this->arena->make<MultiSweepLEDStrip>(stripSweeps, count, (LEDOutput*) output);
+        if (component == NULL) {
+            return this->fail(ERROR_ARENA_FULL);
+        }
+        if (!this->add(gauge, component)) {
+            return false;
+        }
+    }
+    return reader->overrun ? this->fail(ERROR_TRUNCATED) : true;
+}
+
+DevType const *GaugeConfig::screenType(byte type) {
+    switch (type) {
+        case SCREEN_SH1106_128x64:
+            return &SH1106_128x64;
+        case SCREEN_ADAFRUIT_128x64:
+            return &Adafruit128x64;
+        case SCREEN_ADAFRUIT_128x32:
+            return &Adafruit128x32;
+    }
+    return NULL;
+}
+
+bool GaugeConfig::parseScreens(ConfigReader *reader, CompositeGauge *gauge) {
+    bool build = gauge != NULL;
+    byte screenCount = reader->next();
+    for (byte i = 0; i < screenCount; i++) {
+        byte type = reader->next();
+        byte address = reader->next();
+        DevType const *screenType = this->screenType(reader->next());
+        byte resetPin = reader->next();
+        if (screenType == NULL) {
+            return this->fail(ERROR_TYPE);
+        }
+
+        if (type == SCREEN_SINGLE) {
+            byte source = reader->next();
+            byte measurementX = reader->next();
+            byte measurementY = reader->next();
+            byte unitY = reader->next();
+            if (source >= this->sourceCount) {
+                return this->fail(ERROR_INDEX);
+            }
+            this->need(sizeof(SingleDataSourceScreen));
+            this->componentsNeeded++;
+            if (!build) {
+                continue;
+            }
+            SingleDataSourceScreen *screen = this->arena->make<SingleDataSourceScreen>(
+                address, screenType, this->sources[source], resetPin, measurementX, measurementY, unitY
+            );
+            if (screen == NULL) {
+                return this->fail(ERROR_ARENA_FULL);
+            }
+            if (!this->add(gauge, screen)) {
+                return false;
+            }
+        } else if (type == SCREEN_DUAL) {
+            byte topSource = reader->next();
+            byte bottomSource = reader->next();
+            byte measurementX = reader->next();
+            if (topSource >= this->sourceCount || bottomSource >= this->sourceCount) {
+                return this->fail(ERROR_INDEX);
+            }
+            this->need(sizeof(DualDataSourceScreen));
+            this->componentsNeeded++;
+            if (!build) {
+                continue;
+            }
+            DualDataSourceScreen *screen = this->arena->make<DualDataSourceScreen>(
+                this->sources[topSource], this->sources[bottomSource], measurementX, address, screenType, resetPin
+            );
+            if (screen == NULL) {
+                return this->fail(ERROR_ARENA_FULL);
+            }
+            if (!this->add(gauge, screen)) {
+                return false;
+            }
+        } else {
+            return this->fail(ERROR_TYPE);
+        }
+    }
+    return reader->overrun ? this->fail(ERROR_TRUNCATED) : true;
+}
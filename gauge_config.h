@@ -0,0 +1,171 @@
+#ifndef GAUGE_CONFIG_H
+ #define GAUGE_CONFIG_H
+
+#if defined(ESP8266) || defined(ESP32)
+ #include <vector>
+#else
+ #include <ArduinoSTL>
+#endif
+#include <EEPROM.h>
+#include "gauge_fw.h"
+#include "datasource.h"
+#include "display.h"
+#include "arena.h"
+#include "Arduino.h"
+
+using namespace std;
+
+/**
+ * Reads a gauge description byte by byte, keeping a checksum of
+ *  everything read so far
+ */
+class ConfigReader {
+protected:
+    word position = 0;
+    word length;
+    virtual byte readAt(word position) = 0;
+public:
+    byte checksum = 0;
+    bool overrun = false;
+    ConfigReader(word length);
+    byte next(void);
+    word nextWord(void);
+    void rewind(void);
+};
+
+/**
+ * Gauge description in RAM
+ */
+class MemoryConfigReader : public ConfigReader {
+protected:
+    const byte *data;
+    byte readAt(word position);
+public:
+    MemoryConfigReader(const byte *data, word length);
+};
+
+/**
+ * Gauge description in flash (PROGMEM)
+ */
+class FlashConfigReader : public ConfigReader {
+protected:
+    const byte *data;
+    byte readAt(word position);
+public:
+    FlashConfigReader(const byte *data, word length);
+};
+
+/**
+ * Gauge description in EEPROM, starting at 'start'
+ */
+class EEPROMConfigReader : public ConfigReader {
+protected:
+    word start;
+    bool started = false;
+    byte readAt(word position);
+public:
+    EEPROMConfigReader(word start, word length);
+};
+
+
+/**
+ * GaugeConfig
+ * 
+ * Builds a gauge from a binary description, so the same firmware can run
+ *  any layout of sensors, sweeps, LED strips and screens. Every object is
+ *  built in the given arena, nothing is allocated on the heap other than
+ *  the buffers the libraries allocate themselves
+ * 
+ * The description (all words little endian):
+ *   'G' 'F' version
+ *   sensor count, then per sensor:
+ *     SENSOR_TEST     min(word) max(word) speed
+ *     SENSOR_MPX4250  pin adcValueOffset error(word, 1/10000)
+ *     SENSOR_MPX5500  pin adcValueOffset error(word, 1/10000)
+ *   sweep count, then per sweep:
+ *     sensor min(word) max(word) alert(word) base(rgb) alert(rgb) blank(rgb)
+ *     strategy radio sweep led count, sweep leds(word) alert led count, alert leds(word)
+ *   strip count, then per strip:
+ *     pin total leds(word) sweep count, sweeps
+ *   screen count, then per screen:
+ *     SCREEN_SINGLE   address type resetPin sensor x y unitY
+ *     SCREEN_DUAL     address type resetPin topSensor bottomSensor x
+ *   checksum (sum of all the previous bytes)
+ * 
+ * Words and the adcValueOffset byte hold signed values as two's complement,
+ *  a reset pin of 255 means there is none (-1)
+ * 
+ * load() validates the whole description, and checks it fits in what's
+ *  left of the arena and of the gauge, before it builds anything: a bad
+ *  description leaves the gauge and the arena untouched. Validating never
+ *  touches what an earlier load() built. Every LED of a sweep has to be on
+ *  the strips showing it, and there can be up to MAX_SWEEPS sweeps
+ */
+class GaugeConfig {
+protected:
+    Arena *arena;
+    DataSource **sources = NULL;
+    byte sourceCount = 0;
+    IndAddrLEDStripSweep **sweeps = NULL;
+    byte sweepCount = 0;
+    size_t arenaNeeded = 0;
+    byte componentsNeeded = 0;
+    void need(size_t bytes);
+    bool add(CompositeGauge *gauge, GaugeComponent *component);
+    bool parse(ConfigReader *reader, CompositeGauge *gauge);
+    bool parseSensors(ConfigReader *reader, CompositeGauge *gauge);
+    bool parseSweeps(ConfigReader *reader, CompositeGauge *gauge);
+    bool parseStrips(ConfigReader *reader, CompositeGauge *gauge);
+    bool parseScreens(ConfigReader *reader, CompositeGauge *gauge);
+    int *parseColor(ConfigReader *reader, bool build);
+    int *parseLeds(ConfigReader *reader, bool build, byte *count, word *ledsNeeded);
+    IlluminationStrategy *parseStrategy(ConfigReader *reader, bool build);
+    DevType const *screenType(byte type);
+    bool fail(byte error);
+public:
+    static const byte MAX_SWEEPS = 16;
+protected:
+    // how long a strip showing each sweep has to be
+    word sweepLedsNeeded[MAX_SWEEPS];
+public:
+    static const byte MAGIC_0 = 'G';
+    static const byte MAGIC_1 = 'F';
+    static const byte VERSION = 1;
+
+    static const byte SENSOR_TEST = 0;
+    static const byte SENSOR_MPX4250 = 1;
+    static const byte SENSOR_MPX5500 = 2;
+
+    static const byte STRATEGY_FULL_SWEEP = 0;
+    static const byte STRATEGY_INVERSE_FULL_SWEEP = 1;
+    static const byte STRATEGY_LEVEL_ONLY = 2;
+
+    static const byte SCREEN_SINGLE = 0;
+    static const byte SCREEN_DUAL = 1;
+
+    static const byte SCREEN_SH1106_128x64 = 0;
+    static const byte SCREEN_ADAFRUIT_128x64 = 1;
+    static const byte SCREEN_ADAFRUIT_128x32 = 2;
+
+    static const byte ERROR_NONE = 0;
+    static const byte ERROR_HEADER = 1;
+    static const byte ERROR_TYPE = 2;
+    static const byte ERROR_INDEX = 3;
+    static const byte ERROR_TRUNCATED = 4;
+    static const byte ERROR_CHECKSUM = 5;
+    static const byte ERROR_ARENA_FULL = 6;
+    static const byte ERROR_GAUGE_FULL = 7;
+    static const byte ERROR_LED = 8;
+    static const byte ERROR_TOO_MANY_SWEEPS = 9;
+
+    byte error = ERROR_NONE;
+    unsigned long loadMicros = 0;
+
+    GaugeConfig(Arena *arena);
+    bool validate(ConfigReader *reader);
+    bool load(ConfigReader *reader, CompositeGauge *gauge);
+    DataSource *getSource(byte index);
+    byte getSourceCount(void);
+};
+
+#endif
@@ -1,17 +1,179 @@
 #include "gauge_fw.h"
+#include "datasource.h"
+#ifdef __AVR__
+ #include <avr/sleep.h>
+#endif
 
 CompositeGauge::CompositeGauge(void) {}
 
 void CompositeGauge::init(void) {}
 
-void CompositeGauge::add(GaugeComponent *component) {
-    this->components.push_back(component);
+bool CompositeGauge::add(GaugeComponent *component) {
+    if (this->componentCount == MAX_COMPONENTS || !component->isReady()) {
+        return false;
+    }
+
+    // insert after every component of the same or lower depth,
+    //  so components on the same level keep the order they were added in
+    byte depth = component->getDepth();
+    byte position = this->componentCount;
+    while (position > 0 && this->components[position - 1]->getDepth() > depth) {
+        this->components[position] = this->components[position - 1];
+        position--;
+    }
+    this->components[position] = component;
+    this->componentCount++;
+    if (depth != GaugeComponent::DEPTH_SINK) {
+        this->sourceCount++;
+    }
     component->init();
+    return true;
+}
+
+byte CompositeGauge::getComponentCount(void) {
+    return this->componentCount;
+}
+
+bool CompositeGauge::watch(DataSource *source, int deadband) {
+    if (this->watchedCount == MAX_WATCHED) {
+        return false;
+    }
+    this->watched[this->watchedCount] = source;
+    this->deadbands[this->watchedCount] = deadband;
+    this->lastValues[this->watchedCount] = source->raw();
+    this->watchedCount++;
+    return true;
+}
+
+void CompositeGauge::setIdleMode(unsigned long activeInterval, unsigned long idleInterval, word idleAfter) {
+    this->idleMode = true;
+    this->activeInterval = activeInterval;
+    this->idleInterval = idleInterval;
+    this->idleAfter = idleAfter;
+    this->quietTicks = 0;
+    this->resetDutyCycle();
+}
+
+bool CompositeGauge::isIdle(void) {
+    return this->idleMode && this->quietTicks >= this->idleAfter;
+}
+
+bool CompositeGauge::watchedChanged(void) {
+    if (this->watchedCount == 0) {
+        return this->anySourceChanged();
+    }
+
+    bool changed = false;
+    for (byte i = 0; i < this->watchedCount; i++) {
+        int value = this->watched[i]->raw();
+        if (abs(value - this->lastValues[i]) > this->deadbands[i]) {
+            // only move the reference when it changes, so slow drifts add up
+            this->lastValues[i] = value;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool CompositeGauge::anySourceChanged(void) {
+    bool changed = false;
+    byte slot = 0;
+    for (byte i = 0; i < this->componentCount; i++) {
+        DataSource *source;
+        for (byte j = 0; (source = this->components[i]->getSource(j)) != NULL; j++) {
+            // no room to remember its value, take it as moving
+            if (slot == MAX_WATCHED) {
+                return true;
+            }
+            int value = source->raw();
+            if (value != this->lastValues[slot]) {
+                this->lastValues[slot] = value;
+                changed = true;
+            }
+            slot++;
+        }
+    }
+    // no sources to go by (the displays read them from elsewhere), stay awake
+    return changed || slot == 0;
 }
 
 void CompositeGauge::tick(void) {
-    vector<GaugeComponent*>::iterator it;
-    for (it = this->components.begin(); it != this->components.end(); ++it) {
-        (*it)->tick();
+    unsigned long startedAt = micros();
+    if (!this->idleMode) {
+        for (byte i = 0; i < this->componentCount; i++) {
+            this->components[i]->tick();
+        }
+        this->wakeToUpdate = micros() - startedAt;
+        this->busyMicros += this->wakeToUpdate;
+        return;
     }
+
+    unsigned long interval = this->isIdle() ? this->idleInterval : this->activeInterval;
+    if (startedAt - this->lastTickAt < interval) {
+        return;
+    }
+    this->lastTickAt = startedAt;
+
+    // sources first, they decide whether there's anything new to show
+    byte i = 0;
+    for (; i < this->sourceCount; i++) {
+        this->components[i]->tick();
+    }
+
+    bool changed = this->watchedChanged();
+    if (changed) {
+        this->quietTicks = 0;
+    } else if (this->quietTicks < this->idleAfter) {
+        this->quietTicks++;
+    }
+
+    if (changed || !this->isIdle()) {
+        for (; i < this->componentCount; i++) {
+            this->components[i]->tick();
+        }
+        this->wakeToUpdate = micros() - startedAt;
+    }
+    this->busyMicros += micros() - startedAt;
+}
+
+void CompositeGauge::idle(void) {
+    if (!this->idleMode) {
+        delay(0);
+        return;
+    }
+
+    unsigned long interval = this->isIdle() ? this->idleInterval : this->activeInterval;
+    unsigned long elapsed = micros() - this->lastTickAt;
+    if (elapsed >= interval) {
+        delay(0);
+        return;
+    }
+
+#ifdef __AVR__
+    // the timer0 overflow wakes us up about every millisecond
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    while (micros() - this->lastTickAt < interval) {
+        sleep_cpu();
+    }
+    sleep_disable();
+#else
+    // delay() lets the ESP idle (and light/modem sleep when enabled)
+    unsigned long remaining = interval - elapsed;
+    delay(remaining / 1000);
+    delayMicroseconds(remaining % 1000);
+#endif
+}
+
+byte CompositeGauge::dutyCycle(void) {
+    unsigned long total = micros() - this->measuringSince;
+    if (total == 0) {
+        return 100;
+    }
+    return (unsigned long long) this->busyMicros * 100 / total;
+}
+
+void CompositeGauge::resetDutyCycle(void) {
+    this->busyMicros = 0;
+    this->measuringSince = micros();
 }
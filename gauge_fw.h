@@ -1,23 +1,47 @@
 #ifndef GAUGEFW_H
  #define GAUGEFW_H
 
-#ifdef ESP8266 || defined(ESP32)
+#if defined(ESP8266) || defined(ESP32)
  #include <vector>
 #else
  #include <ArduinoSTL>
 #endif
+#include "Arduino.h"
 
 using namespace std;
 
+class DataSource;
+
 /**
  * GaugeComponent Interface
  * 
  * Defines the contract for composable gauge components
+ *
+ * The depth places the component in the dependency graph of the gauge:
+ *  sensors are 0, sources derived from other sources are one level
+ *  deeper than their deepest input, and everything that only consumes
+ *  data (LEDs, screens) is a sink and goes last; sensors get their
+ *  depth from SourceComponent (datasource.h)
+ * 
+ * getSource() lists the DataSources the component samples, if any
+ * 
+ * isReady() is false when the component couldn't get what it needs to
+ *  work, like its buffers from the framework arena (see arena.h)
  */
 class GaugeComponent {
 public:
+    static const byte DEPTH_SINK = 255;
     virtual void tick(void) = 0;
     virtual void init(void) = 0;
+    virtual byte getDepth(void) {
+        return DEPTH_SINK;
+    };
+    virtual DataSource *getSource(byte index) {
+        return NULL;
+    };
+    virtual bool isReady(void) {
+        return true;
+    };
 };
 
 
@@ -27,15 +51,66 @@ public:
  * A container that takes GaugeComponents, inits them and 
  *  calls tick() on each one at each loop iteration
  *  
- * Always add the sensors before any other component
+ * Components are kept ordered by depth, so every source is ticked
+ *  (and its value cached for the tick) before anything reading it,
+ *  regardless of the order they were added in
+ * 
+ * Holds up to MAX_COMPONENTS, add() returns false when full, and when
+ *  the component isn't ready (it would only sit there doing nothing)
+ * 
+ * Idle mode: once setIdleMode() is called, the gauge ticks at most every
+ *  'activeInterval' microseconds, and after 'idleAfter' ticks in which no
+ *  watch()ed source moved beyond its deadband, only every 'idleInterval'.
+ *  While idle, LEDs and screens are only refreshed when something
+ *  changed. Calling idle() from loop() sleeps until the next tick is due;
+ *  any change brings the gauge back to the active interval right away
+ * 
+ * dutyCycle() is the share of time (%) spent ticking since the last
+ *  resetDutyCycle(), and wakeToUpdate how long the last tick that
+ *  refreshed the displays took, both in idle mode or not
+ * 
+ * Without any watch()ed source, every source in the gauge is watched with
+ *  no deadband, so nothing on display can freeze while its value moves;
+ *  past MAX_WATCHED sources that way the gauge never idles
  */
 class CompositeGauge {
-    vector<GaugeComponent*> components;
 public:
+    static const byte MAX_COMPONENTS = 16;
+    static const byte MAX_WATCHED = 8;
+private:
+    GaugeComponent *components[MAX_COMPONENTS];
+    byte componentCount = 0;
+    // the sources come first, the sinks after them
+    byte sourceCount = 0;
+
+    DataSource *watched[MAX_WATCHED];
+    int deadbands[MAX_WATCHED];
+    int lastValues[MAX_WATCHED];
+    byte watchedCount = 0;
+
+    bool idleMode = false;
+    unsigned long activeInterval = 0;
+    unsigned long idleInterval = 0;
+    word idleAfter = 0;
+    word quietTicks = 0;
+    unsigned long lastTickAt = 0;
+    unsigned long busyMicros = 0;
+    unsigned long measuringSince = 0;
+    bool watchedChanged(void);
+    bool anySourceChanged(void);
+public:
+    unsigned long wakeToUpdate = 0;
     CompositeGauge(void);
-    void add(GaugeComponent *component);
+    bool add(GaugeComponent *component);
+    byte getComponentCount(void);
+    bool watch(DataSource *source, int deadband);
+    void setIdleMode(unsigned long activeInterval, unsigned long idleInterval, word idleAfter);
+    bool isIdle(void);
     void init(void);
     void tick(void);
+    void idle(void);
+    byte dutyCycle(void);
+    void resetDutyCycle(void);
 };
 
 #endif
@@ -0,0 +1,83 @@
+#include "latency.h"
+#include "arena.h"
+
+LatencyHistogram::LatencyHistogram(void) {
+    this->reset();
+}
+
+void LatencyHistogram::record(unsigned long latency) {
+    byte bucket = 0;
+    while (latency >> bucket && bucket < BUCKETS - 1) {
+        bucket++;
+    }
+    this->buckets[bucket]++;
+    this->count++;
+    this->totalLatency += latency;
+    if (latency > this->maxLatency) {
+        this->maxLatency = latency;
+    }
+}
+
+void LatencyHistogram::reset(void) {
+    for (byte i = 0; i < BUCKETS; i++) {
+        this->buckets[i] = 0;
+    }
+    this->count = 0;
+    this->maxLatency = 0;
+    this->totalLatency = 0;
+}
+
+unsigned long LatencyHistogram::average(void) {
+    return this->count ? this->totalLatency / this->count : 0;
+}
+
+void LatencyHistogram::print(Print *out, const char *label) {
+    out->print(label);
+    out->print(F(": n="));
+    out->print(this->count);
+    out->print(F(" avg="));
+    out->print(this->average());
+    out->print(F("us max="));
+    out->print(this->maxLatency);
+    out->println(F("us"));
+    for (byte i = 0; i < BUCKETS; i++) {
+        if (this->buckets[i] == 0) {
+            continue;
+        }
+        if (i == BUCKETS - 1) {
+            out->print(F("  >="));
+            out->print(1UL << (i - 1));
+        } else {
+            out->print(F("  <"));
+            out->print(1UL << i);
+        }
+        out->print(F("us: "));
+        out->println(this->buckets[i]);
+    }
+}
+
+
+
+void LatencyTraced::trace(byte output, unsigned long sampledAt) {
+    if (this->latency == NULL || output >= MAX_TRACED) {
+        return;
+    }
+    // never sampled, or this output already showed that sample
+    if (sampledAt == 0 || sampledAt == this->lastTraced[output]) {
+        return;
+    }
+    this->lastTraced[output] = sampledAt;
+    this->latency->record(micros() - sampledAt);
+}
+
+bool LatencyTraced::setLatencyHistogram(LatencyHistogram *latency) {
+    if (this->lastTraced == NULL) {
+        this->lastTraced = (unsigned long*) Arena::framework()->allocate(MAX_TRACED * sizeof(unsigned long));
+        for (byte i = 0; this->lastTraced != NULL && i < MAX_TRACED; i++) {
+            this->lastTraced[i] = 0;
+        }
+    }
+    // no room to remember what was traced, leave tracing off
+    this->latency = this->lastTraced == NULL ? NULL : latency;
+    return this->lastTraced != NULL;
+}
@@ -0,0 +1,47 @@
+#ifndef LATENCY_H
+ #define LATENCY_H
+
+#include "Arduino.h"
+
+/**
+ * Histogram of sensor-to-output latencies
+ * 
+ * Bucket N counts the latencies between 2^(N-1) and 2^N microseconds,
+ *  the last bucket also counts everything above that
+ */
+class LatencyHistogram {
+public:
+    static const byte BUCKETS = 20;
+    unsigned long buckets[BUCKETS];
+    unsigned long count = 0;
+    unsigned long maxLatency = 0;
+    unsigned long totalLatency = 0;
+    LatencyHistogram(void);
+    void record(unsigned long latency);
+    void reset(void);
+    unsigned long average(void);
+    void print(Print *out, const char *label);
+};
+
+
+/**
+ * Output components that can measure how long it took since the
+ *  sample they display was read from the sensor
+ * 
+ * Each sample is counted once per output (a screen showing two values
+ *  has two outputs), the first time it's shown; refreshing the same
+ *  sample again, or a source that wasn't sampled yet, isn't counted.
+ *  Tracing is off until a histogram is set; setting it returns false
+ *  when there's no room in the framework arena to trace
+ */
+class LatencyTraced {
+protected:
+    LatencyHistogram *latency = NULL;
+    unsigned long *lastTraced = NULL;
+    void trace(byte output, unsigned long sampledAt);
+public:
+    static const byte MAX_TRACED = 8;
+    bool setLatencyHistogram(LatencyHistogram *latency);
+};
+
+#endif
@@ -0,0 +1,304 @@
+#include "obd.h"
+
+#ifdef ESP32
+TwaiCanBus::TwaiCanBus(byte txPin, byte rxPin) : CanBus() {
+    this->txPin = txPin;
+    this->rxPin = rxPin;
+}
+
+bool TwaiCanBus::begin(void) {
+    // OBD-II over CAN runs at 500 kbit/s
+    twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT((gpio_num_t) this->txPin, (gpio_num_t) this->rxPin, TWAI_MODE_NORMAL);
+    // room for the responses that arrive between two (idle) ticks
+    general.rx_queue_len = RX_QUEUE_LENGTH;
+    twai_timing_config_t timing = TWAI_TIMING_CONFIG_500KBITS();
+    // only let the ECU responses (0x7E8-0x7EF) in, so powertrain traffic
+    //  on the same bus can't fill the queue. Standard IDs sit in bits 31..21,
+    //  mask bits set to 1 are "don't care"
+    twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    filter.acceptance_code = OBDBus::FIRST_RESPONSE_ID << 21;
+    filter.acceptance_mask = ((OBDBus::FIRST_RESPONSE_ID ^ OBDBus::LAST_RESPONSE_ID) << 21) | 0x1FFFFF;
+    filter.single_filter = true;
+    if (twai_driver_install(&general, &timing, &filter) != ESP_OK) {
+        return false;
+    }
+    return twai_start() == ESP_OK;
+}
+
+bool TwaiCanBus::send(const CanFrame *frame) {
+    twai_message_t message = {};
+    message.identifier = frame->id;
+    message.data_length_code = frame->length;
+    memcpy(message.data, frame->data, frame->length);
+    return twai_transmit(&message, 0) == ESP_OK;
+}
+
+bool TwaiCanBus::receive(CanFrame *frame) {
+    twai_message_t message;
+    if (twai_receive(&message, 0) != ESP_OK) {
+        return false;
+    }
+    frame->id = message.identifier;
+    frame->length = message.data_length_code > 8 ? 8 : message.data_length_code;
+    memcpy(frame->data, message.data, frame->length);
+    return true;
+}
+#endif
+
+
+
+OBDSource::OBDSource(byte pid) : DataSource() {
+    this->pid = pid;
+}
+
+byte OBDSource::getPid(void) {
+    return this->pid;
+}
+
+void OBDSource::update(const byte *data, byte length, unsigned long at) {
+    this->value = decode(this->pid, data, length);
+    this->sampledAt = at;
+}
+
+void OBDSource::init(void) {}
+
+void OBDSource::read(void) {}
+
+int OBDSource::raw(void) {
+    return this->value;
+}
+
+void OBDSource::formatTo(char *buffer) {
+    dtostrf(this->value, 5, 0, buffer);
+}
+
+const char *OBDSource::unit(void) {
+    switch (this->pid) {
+        case PID_INTAKE_PRESSURE:
+        case PID_BAROMETRIC_PRESSURE:
+            return "kpa";
+        case PID_COOLANT_TEMP:
+        case PID_INTAKE_TEMP:
+            return "C";
+        case PID_RPM:
+            return "rpm";
+        case PID_SPEED:
+            return "km/h";
+        case PID_ENGINE_LOAD:
+        case PID_THROTTLE:
+            return "%";
+    }
+    return "";
+}
+
+/**
+ * Turns the data bytes of a response (A, B...) into engineering units
+ */
+int OBDSource::decode(byte pid, const byte *data, byte length) {
+    if (length == 0) {
+        return 0;
+    }
+    switch (pid) {
+        case PID_ENGINE_LOAD:
+        case PID_THROTTLE:
+            return (data[0] * 100 + 127) / 255;
+        case PID_COOLANT_TEMP:
+        case PID_INTAKE_TEMP:
+            return data[0] - 40;
+        case PID_RPM:
+            return length < 2 ? 0 : ((word) data[0] << 8 | data[1]) / 4;
+    }
+    return length < 2 ? data[0] : ((word) data[0] << 8 | data[1]);
+}
+
+/**
+ * The other way around, for simulated ECUs; returns how many data bytes
+ *  were written
+ */
+byte OBDSource::encode(byte pid, int value, byte *data) {
+    switch (pid) {
+        case PID_ENGINE_LOAD:
+        case PID_THROTTLE:
+            data[0] = constrain(((long) value * 255 + 50) / 100, 0, 255);
+            return 1;
+        case PID_COOLANT_TEMP:
+        case PID_INTAKE_TEMP:
+            data[0] = constrain(value + 40, 0, 255);
+            return 1;
+        case PID_RPM: {
+            word quarters = constrain((long) value * 4, 0, 65535);
+            data[0] = quarters >> 8;
+            data[1] = quarters & 0xFF;
+            return 2;
+        }
+    }
+    data[0] = constrain(value, 0, 255);
+    return 1;
+}
+
+
+
+OBDBus::OBDBus(CanBus *bus, byte maxInFlight, unsigned long timeout) : GaugeComponent() {
+    this->bus = bus;
+    this->maxInFlight = maxInFlight;
+    this->timeout = timeout;
+}
+
+bool OBDBus::add(OBDSource *source) {
+    if (this->sourceCount == MAX_SOURCES) {
+        return false;
+    }
+    this->sources[this->sourceCount] = source;
+    this->requestedAt[this->sourceCount] = 0;
+    this->sourceCount++;
+    return true;
+}
+
+void OBDBus::init(void) {
+    this->started = this->bus->begin();
+    this->online = this->started;
+    this->silentTimeouts = 0;
+}
+
+void OBDBus::tick(void) {
+    if (!this->started) {
+        return;
+    }
+    this->receiveResponses();
+    this->expireRequests();
+    this->sendRequests();
+}
+
+bool OBDBus::isOnline(void) {
+    return this->online;
+}
+
+byte OBDBus::getDepth(void) {
+    return 0;
+}
+
+DataSource *OBDBus::getSource(byte index) {
+    return index < this->sourceCount ? this->sources[index] : NULL;
+}
+
+void OBDBus::receiveResponses(void) {
+    CanFrame frame;
+    while (this->bus->receive(&frame)) {
+        // single frame mode 01 response: length, 0x41, pid, data...
+        if (frame.id < FIRST_RESPONSE_ID || frame.id > LAST_RESPONSE_ID ||
+            frame.length < 3 || frame.data[1] != 0x41) {
+            continue;
+        }
+
+        unsigned long now = micros();
+        this->online = true;
+        this->silentTimeouts = 0;
+        // the first byte counts the mode and pid bytes too
+        byte dataLength = frame.data[0] < frame.length ? frame.data[0] : frame.length - 1;
+        dataLength = dataLength > 2 ? dataLength - 2 : 0;
+        for (byte i = 0; i < this->sourceCount; i++) {
+            if (this->sources[i]->getPid() != frame.data[2]) {
+                continue;
+            }
+            this->sources[i]->update(&frame.data[3], dataLength, now);
+            if (this->requestedAt[i] != 0) {
+                trace(i, this->requestedAt[i]);
+                this->requestedAt[i] = 0;
+                this->inFlight--;
+            }
+            this->responses++;
+        }
+    }
+}
+
+void OBDBus::expireRequests(void) {
+    unsigned long now = micros();
+    for (byte i = 0; i < this->sourceCount; i++) {
+        if (this->requestedAt[i] != 0 && now - this->requestedAt[i] > this->timeout) {
+            this->requestedAt[i] = 0;
+            this->inFlight--;
+            this->timeouts++;
+            if (this->silentTimeouts < OFFLINE_TIMEOUTS && ++this->silentTimeouts == OFFLINE_TIMEOUTS) {
+                this->online = false;
+            }
+        }
+    }
+}
+
+void OBDBus::sendRequests(void) {
+    // go around the sources once at most, skipping the ones still pending
+    for (byte checked = 0; checked < this->sourceCount && this->inFlight < this->maxInFlight; checked++) {
+        byte i = this->nextSource;
+        this->nextSource = (this->nextSource + 1) % this->sourceCount;
+        if (this->requestedAt[i] != 0) {
+            continue;
+        }
+
+        CanFrame request = {REQUEST_ID, 8, {2, 0x01, this->sources[i]->getPid(), 0x55, 0x55, 0x55, 0x55, 0x55}};
+        if (!this->bus->send(&request)) {
+            // transmit queue full, try again next tick
+            return;
+        }
+        // 0 means idle, so never record a request at 0
+        this->requestedAt[i] = micros() | 1;
+        this->inFlight++;
+        this->requests++;
+    }
+}
+
+
+
+SimulatedECU::SimulatedECU(unsigned long responseDelay) : CanBus() {
+    this->responseDelay = responseDelay;
+}
+
+bool SimulatedECU::simulate(byte pid, DataSource *source) {
+    if (this->pidCount == MAX_PIDS) {
+        return false;
+    }
+    this->pids[this->pidCount] = pid;
+    this->values[this->pidCount] = source;
+    this->pidCount++;
+    return true;
+}
+
+bool SimulatedECU::begin(void) {
+    return true;
+}
+
+bool SimulatedECU::send(const CanFrame *frame) {
+    if (frame->id != OBDBus::REQUEST_ID || frame->length < 3 || frame->data[1] != 0x01) {
+        return true;
+    }
+    if (this->queueLength == QUEUE_SIZE) {
+        return false;
+    }
+
+    for (byte i = 0; i < this->pidCount; i++) {
+        if (this->pids[i] != frame->data[2]) {
+            continue;
+        }
+        byte slot = (this->queueStart + this->queueLength) % QUEUE_SIZE;
+        CanFrame *response = &this->queue[slot];
+        response->id = OBDBus::FIRST_RESPONSE_ID;
+        response->length = 8;
+        memset(response->data, 0x55, 8);
+        response->data[1] = 0x41;
+        response->data[2] = this->pids[i];
+        response->data[0] = 2 + OBDSource::encode(this->pids[i], this->values[i]->raw(), &response->data[3]);
+        this->dueAt[slot] = micros() + this->responseDelay;
+        this->queueLength++;
+        break;
+    }
+    return true;
+}
+
+bool SimulatedECU::receive(CanFrame *frame) {
+    if (this->queueLength == 0 || (long) (micros() - this->dueAt[this->queueStart]) < 0) {
+        return false;
+    }
+    *frame = this->queue[this->queueStart];
+    this->queueStart = (this->queueStart + 1) % QUEUE_SIZE;
+    this->queueLength--;
+    return true;
+}
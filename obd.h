@@ -0,0 +1,166 @@
+#ifndef OBD_H
+ #define OBD_H
+
+#include "gauge_fw.h"
+#include "datasource.h"
+#include "latency.h"
+#include "Arduino.h"
+#ifdef ESP32
+ #include <driver/twai.h>
+#endif
+
+/**
+ * A classic (11 bit id) CAN frame
+ */
+struct CanFrame {
+    unsigned long id;
+    byte length;
+    byte data[8];
+};
+
+
+/**
+ * CAN Bus driver interface
+ * 
+ * send() and receive() never wait, they return false when the
+ *  transmit queue is full or there's nothing to read
+ */
+class CanBus {
+public:
+    virtual bool begin(void) = 0;
+    virtual bool send(const CanFrame *frame) = 0;
+    virtual bool receive(CanFrame *frame) = 0;
+};
+
+
+#ifdef ESP32
+/**
+ * The ESP32 built-in CAN controller (TWAI), needs an external transceiver
+ */
+class TwaiCanBus : public CanBus {
+public:
+    static const word RX_QUEUE_LENGTH = 32;
+protected:
+    byte txPin;
+    byte rxPin;
+public:
+    TwaiCanBus(byte txPin, byte rxPin);
+    bool begin(void);
+    bool send(const CanFrame *frame);
+    bool receive(CanFrame *frame);
+};
+#endif
+
+
+/**
+ * OBD-II mode 01 (current data) DataSource
+ * 
+ * The value is decoded to whole engineering units (kPa, C, rpm, km/h, %)
+ *  and cached until the next response, reading it never touches the bus.
+ *  Polled by an OBDBus
+ */
+class OBDSource : public DataSource {
+protected:
+    byte pid;
+    int value = 0;
+public:
+    static const byte PID_ENGINE_LOAD = 0x04;
+    static const byte PID_COOLANT_TEMP = 0x05;
+    static const byte PID_INTAKE_PRESSURE = 0x0B;
+    static const byte PID_RPM = 0x0C;
+    static const byte PID_SPEED = 0x0D;
+    static const byte PID_INTAKE_TEMP = 0x0F;
+    static const byte PID_THROTTLE = 0x11;
+    static const byte PID_BAROMETRIC_PRESSURE = 0x33;
+
+    OBDSource(byte pid);
+    byte getPid(void);
+    void update(const byte *data, byte length, unsigned long at);
+    void init(void);
+    void read(void);
+    int raw(void);
+    void formatTo(char *buffer);
+    const char *unit(void);
+
+    static int decode(byte pid, const byte *data, byte length);
+    static byte encode(byte pid, int value, byte *data);
+};
+
+
+/**
+ * OBDBus
+ * 
+ * Polls a set of OBDSources over a shared CanBus without ever waiting
+ *  for the ECU: each tick it reads whatever responses arrived into the
+ *  sources, drops requests that timed out, and sends new requests
+ *  (round robin) until 'maxInFlight' are pending
+ * 
+ *  If the bus fails to start in init() the OBDBus stays offline (see
+ *  isOnline()) and tick() does nothing. Once started it goes offline
+ *  after OFFLINE_TIMEOUTS requests in a row time out (ECU off, wiring...)
+ *  but keeps polling, and the next response puts it back online
+ */
+class OBDBus : public GaugeComponent, public LatencyTraced {
+public:
+    static const byte MAX_SOURCES = 8;
+    static const unsigned long REQUEST_ID = 0x7DF;
+    static const unsigned long FIRST_RESPONSE_ID = 0x7E8;
+    static const unsigned long LAST_RESPONSE_ID = 0x7EF;
+    static const byte OFFLINE_TIMEOUTS = 3;
+protected:
+    CanBus *bus;
+    OBDSource *sources[MAX_SOURCES];
+    unsigned long requestedAt[MAX_SOURCES];
+    byte sourceCount = 0;
+    byte nextSource = 0;
+    byte inFlight = 0;
+    byte maxInFlight;
+    bool started = false;
+    bool online = false;
+    byte silentTimeouts = 0;
+    unsigned long timeout;
+    void receiveResponses(void);
+    void expireRequests(void);
+    void sendRequests(void);
+public:
+    unsigned long requests = 0;
+    unsigned long responses = 0;
+    unsigned long timeouts = 0;
+    OBDBus(CanBus *bus, byte maxInFlight = 2, unsigned long timeout = 100000);
+    bool add(OBDSource *source);
+    void init(void);
+    void tick(void);
+    bool isOnline(void);
+    byte getDepth(void);
+    DataSource *getSource(byte index);
+};
+
+
+/**
+ * A fake ECU on a loopback bus, answering mode 01 requests with the
+ *  values of local DataSources after 'responseDelay' microseconds
+ * 
+ *  Useful to try OBD gauges with software only ;)
+ */
+class SimulatedECU : public CanBus {
+public:
+    static const byte MAX_PIDS = 8;
+    static const byte QUEUE_SIZE = 8;
+protected:
+    byte pids[MAX_PIDS];
+    DataSource *values[MAX_PIDS];
+    byte pidCount = 0;
+    unsigned long responseDelay;
+    CanFrame queue[QUEUE_SIZE];
+    unsigned long dueAt[QUEUE_SIZE];
+    byte queueStart = 0;
+    byte queueLength = 0;
+public:
+    SimulatedECU(unsigned long responseDelay = 2000);
+    bool simulate(byte pid, DataSource *source);
+    bool begin(void);
+    bool send(const CanFrame *frame);
+    bool receive(CanFrame *frame);
+};
+
+#endif
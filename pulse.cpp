@@ -0,0 +1,270 @@
+#include "pulse.h"
+
+PulseInput *PulseInput::attached[PulseInput::MAX_ATTACHED] = {NULL, NULL, NULL, NULL};
+byte PulseInput::attachedPins[PulseInput::MAX_ATTACHED];
+int PulseInput::attachedModes[PulseInput::MAX_ATTACHED];
+
+void GAUGE_ISR_ATTR PulseInput::onInterrupt(byte slot) {
+    // the pin may have moved again by now, only read it when we have to
+    bool level;
+    if (attachedModes[slot] == RISING) {
+        level = true;
+    } else if (attachedModes[slot] == FALLING) {
+        level = false;
+    } else {
+        level = digitalRead(attachedPins[slot]) == HIGH;
+    }
+    attached[slot]->edge(micros(), level);
+}
+
+void GAUGE_ISR_ATTR PulseInput::onInterrupt0(void) {
+    onInterrupt(0);
+}
+
+void GAUGE_ISR_ATTR PulseInput::onInterrupt1(void) {
+    onInterrupt(1);
+}
+
+void GAUGE_ISR_ATTR PulseInput::onInterrupt2(void) {
+    onInterrupt(2);
+}
+
+void GAUGE_ISR_ATTR PulseInput::onInterrupt3(void) {
+    onInterrupt(3);
+}
+
+void PulseInput::lockEdges(void) {
+#ifdef ESP32
+    portENTER_CRITICAL(&this->edgeLock);
+#else
+    noInterrupts();
+#endif
+}
+
+void PulseInput::unlockEdges(void) {
+#ifdef ESP32
+    portEXIT_CRITICAL(&this->edgeLock);
+#else
+    interrupts();
+#endif
+}
+
+// elsewhere edge() already runs with interrupts off, or from the same
+//  core as read() when it comes from software
+void GAUGE_ISR_ATTR PulseInput::lockFromEdge(void) {
+#ifdef ESP32
+    portENTER_CRITICAL_SAFE(&this->edgeLock);
+#endif
+}
+
+void GAUGE_ISR_ATTR PulseInput::unlockFromEdge(void) {
+#ifdef ESP32
+    portEXIT_CRITICAL_SAFE(&this->edgeLock);
+#endif
+}
+
+/**
+ * Routes the interrupts of 'pin' to edge(), returns false when all
+ *  the interrupt slots are taken
+ */
+bool PulseInput::attach(byte pin, int mode) {
+    static void (*handlers[MAX_ATTACHED])(void) = {
+        &PulseInput::onInterrupt0,
+        &PulseInput::onInterrupt1,
+        &PulseInput::onInterrupt2,
+        &PulseInput::onInterrupt3
+    };
+
+    for (byte slot = 0; slot < MAX_ATTACHED; slot++) {
+        if (attached[slot] == NULL) {
+            attached[slot] = this;
+            attachedPins[slot] = pin;
+            attachedModes[slot] = mode;
+            pinMode(pin, INPUT);
+            attachInterrupt(digitalPinToInterrupt(pin), handlers[slot], mode);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+
+FrequencySensor::FrequencySensor(
+    byte pin,
+    unsigned long scale,
+    const char *unitName,
+    unsigned long timeout
+    ) : SourceComponent(), PulseInput() {
+    this->pin = pin;
+    this->scale = scale;
+    this->unitName = unitName;
+    this->timeout = timeout;
+}
+
+void GAUGE_ISR_ATTR FrequencySensor::edge(unsigned long at, bool level) {
+    // one period per rising edge
+    if (!level) {
+        return;
+    }
+    this->lockFromEdge();
+    this->edges++;
+    this->lastEdgeAt = at;
+    this->unlockFromEdge();
+}
+
+void FrequencySensor::read(void) {
+    this->lockEdges();
+    unsigned long edges = this->edges;
+    unsigned long lastEdgeAt = this->lastEdgeAt;
+    this->unlockEdges();
+
+    unsigned long now = micros();
+    unsigned long newEdges = edges - this->countedEdges;
+
+    // average the period over every edge since the last one we counted,
+    //  the first edge (at start or after a timeout) only starts counting
+    if (newEdges > 0) {
+        if (this->primed) {
+            unsigned long period = (lastEdgeAt - this->countedEdgeAt + newEdges / 2) / newEdges;
+            unsigned long rate = period > 0 ? this->scale / period : 0;
+            this->value = rate > 32767 ? 32767 : rate;
+        }
+        this->countedEdges = edges;
+        this->countedEdgeAt = lastEdgeAt;
+        this->primed = true;
+    } else if (now - this->countedEdgeAt > this->timeout) {
+        // the stall isn't a period, don't average it in when it comes back
+        this->value = 0;
+        this->primed = false;
+    }
+    this->sampledAt = now;
+}
+
+void FrequencySensor::tick(void) {
+    this->read();
+}
+
+void FrequencySensor::init(void) {
+    if (this->pin != NO_PIN) {
+        this->attach(this->pin, RISING);
+    }
+}
+
+int FrequencySensor::raw(void) {
+    return this->value;
+}
+
+void FrequencySensor::formatTo(char *buffer) {
+    dtostrf(this->value, 5, 0, buffer);
+}
+
+const char *FrequencySensor::unit(void) {
+    return this->unitName;
+}
+
+
+
+PulseWidthSensor::PulseWidthSensor(
+    byte pin,
+    unsigned long timeout
+    ) : SourceComponent(), PulseInput() {
+    this->pin = pin;
+    this->timeout = timeout;
+}
+
+void GAUGE_ISR_ATTR PulseWidthSensor::edge(unsigned long at, bool level) {
+    this->lockFromEdge();
+    if (level) {
+        this->risingAt = at;
+    } else if (this->risingAt != 0) {
+        this->widthTotal += at - this->risingAt;
+        this->widths++;
+    }
+    this->lastEdgeAt = at;
+    this->unlockFromEdge();
+}
+
+void PulseWidthSensor::read(void) {
+    this->lockEdges();
+    unsigned long widthTotal = this->widthTotal;
+    word widths = this->widths;
+    unsigned long lastEdgeAt = this->lastEdgeAt;
+    this->widthTotal = 0;
+    this->widths = 0;
+    this->unlockEdges();
+
+    unsigned long now = micros();
+    if (widths > 0) {
+        unsigned long width = widthTotal / widths;
+        this->value = width > 32767 ? 32767 : width;
+    } else if (now - lastEdgeAt > this->timeout) {
+        this->value = 0;
+    }
+    this->sampledAt = now;
+}
+
+void PulseWidthSensor::tick(void) {
+    this->read();
+}
+
+void PulseWidthSensor::init(void) {
+    if (this->pin != NO_PIN) {
+        this->attach(this->pin, CHANGE);
+    }
+}
+
+int PulseWidthSensor::raw(void) {
+    return this->value;
+}
+
+void PulseWidthSensor::formatTo(char *buffer) {
+    dtostrf(this->value, 5, 0, buffer);
+}
+
+const char *PulseWidthSensor::unit(void) {
+    return "us";
+}
+
+
+
+PulseTrainGenerator::PulseTrainGenerator(
+    PulseInput *target,
+    unsigned long period,
+    byte dutyPercent
+    ) : GaugeComponent() {
+    this->target = target;
+    this->period = period;
+    this->dutyPercent = dutyPercent;
+}
+
+void PulseTrainGenerator::setPeriod(unsigned long period) {
+    // coming back from a stop, don't make up for the edges it missed
+    if (this->period == 0 && period != 0) {
+        this->nextEdgeAt = micros();
+    }
+    this->period = period;
+}
+
+void PulseTrainGenerator::tick(void) {
+    if (this->period == 0) {
+        return;
+    }
+
+    unsigned long now = micros();
+    unsigned long highTime = this->period * this->dutyPercent / 100;
+    // emit every edge that should have happened since the last tick
+    while ((long) (now - this->nextEdgeAt) >= 0) {
+        this->level = !this->level;
+        this->target->edge(this->nextEdgeAt, this->level);
+        this->nextEdgeAt += this->level ? highTime : this->period - highTime;
+    }
+}
+
+void PulseTrainGenerator::init(void) {
+    this->nextEdgeAt = micros();
+}
+
+byte PulseTrainGenerator::getDepth(void) {
+    return 0;
+}
@@ -0,0 +1,134 @@
+#ifndef PULSE_H
+ #define PULSE_H
+
+#include "gauge_fw.h"
+#include "datasource.h"
+#include "Arduino.h"
+
+// interrupt handlers need to live in RAM on the ESPs
+#if defined(ESP8266) || defined(ESP32)
+ #define GAUGE_ISR_ATTR IRAM_ATTR
+#else
+ #define GAUGE_ISR_ATTR
+#endif
+
+/**
+ * Abstract pulse input
+ * 
+ * Receives the edges of a digital signal, either from a pin interrupt
+ *  (see attach()) or from software, like a PulseTrainGenerator.
+ *  edge() runs inside the interrupt, so it must only count and
+ *  timestamp, the math happens later in tick()
+ * 
+ *  What edge() counts is shared with read() under lockEdges() (from
+ *  read()) and lockFromEdge() (from edge()): interrupts off will do on
+ *  one core, but on the ESP32 the interrupt may run on the other core
+ *  (DualCoreGauge), so there it's a spinlock critical section
+ */
+class PulseInput {
+protected:
+#ifdef ESP32
+    portMUX_TYPE edgeLock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+    void lockEdges(void);
+    void unlockEdges(void);
+    void lockFromEdge(void);
+    void unlockFromEdge(void);
+    static const byte MAX_ATTACHED = 4;
+    static PulseInput *attached[MAX_ATTACHED];
+    static byte attachedPins[MAX_ATTACHED];
+    static int attachedModes[MAX_ATTACHED];
+    static void onInterrupt0(void);
+    static void onInterrupt1(void);
+    static void onInterrupt2(void);
+    static void onInterrupt3(void);
+    static void onInterrupt(byte slot);
+public:
+    static const byte NO_PIN = 255;
+    virtual void edge(unsigned long at, bool level) = 0;
+    bool attach(byte pin, int mode);
+};
+
+
+/**
+ * Frequency input (tach, vehicle speed sensor)
+ * 
+ * value = scale / average period in microseconds, eg. for RPM with 2
+ *  pulses per revolution the scale is 60000000 / 2, for km/h with a
+ *  4000 pulses per km sender it is 3600000000 / 4000. The period is
+ *  averaged over every edge that arrived since the previous tick, and
+ *  the value drops to 0 after 'timeout' microseconds without edges
+ */
+class FrequencySensor : public SourceComponent, public PulseInput {
+protected:
+    byte pin;
+    unsigned long scale;
+    unsigned long timeout;
+    const char *unitName;
+    volatile unsigned long edges = 0;
+    volatile unsigned long lastEdgeAt = 0;
+    unsigned long countedEdges = 0;
+    unsigned long countedEdgeAt = 0;
+    bool primed = false;
+    int value = 0;
+public:
+    FrequencySensor(byte pin, unsigned long scale, const char *unitName = "rpm", unsigned long timeout = 500000);
+    void edge(unsigned long at, bool level);
+    void read(void);
+    void tick(void);
+    void init(void);
+    int raw(void);
+    void formatTo(char *buffer);
+    const char *unit(void);
+};
+
+
+/**
+ * Pulse width input (injector pulse width, PWM senders), value is the
+ *  average high time in microseconds since the previous tick
+ */
+class PulseWidthSensor : public SourceComponent, public PulseInput {
+protected:
+    byte pin;
+    unsigned long timeout;
+    volatile unsigned long risingAt = 0;
+    volatile unsigned long widthTotal = 0;
+    volatile word widths = 0;
+    volatile unsigned long lastEdgeAt = 0;
+    int value = 0;
+public:
+    PulseWidthSensor(byte pin, unsigned long timeout = 500000);
+    void edge(unsigned long at, bool level);
+    void read(void);
+    void tick(void);
+    void init(void);
+    int raw(void);
+    void formatTo(char *buffer);
+    const char *unit(void);
+};
+
+
+/**
+ * Generates a pulse train into a PulseInput, with the edges timestamped
+ *  where they would have happened, no matter how often it's ticked
+ * 
+ *  Useful to simulate tach/speed signals with software only ;)
+ *  Add it to the gauge before the sensor it feeds. A period of 0 stops
+ *  the signal, setting one again starts it over from that moment
+ */
+class PulseTrainGenerator : public GaugeComponent {
+protected:
+    PulseInput *target;
+    unsigned long period;
+    byte dutyPercent;
+    unsigned long nextEdgeAt = 0;
+    bool level = false;
+public:
+    PulseTrainGenerator(PulseInput *target, unsigned long period, byte dutyPercent = 50);
+    void setPeriod(unsigned long period);
+    void tick(void);
+    void init(void);
+    byte getDepth(void);
+};
+
+#endif
@@ -0,0 +1,44 @@
+#include "calibration.h"
+#if defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+ #define CYCLES() __rdtsc()
+#else
+ #define CYCLES() 0ULL
+#endif
+
+// time per CalibrationCurve::lookup(), for an evenly spaced table (segment
+//  found by division) and an uneven one (binary search), over every raw
+//  level of a 10 bit ADC; cycles are the TSC's, x86 only
+
+static const CalibrationPoint thermistor[] = {
+    {100, 1500}, {150, 1300}, {200, 1100}, {275, 950}, {350, 800}, {475, 650},
+    {600, 500}, {750, 350}, {900, 200}
+};
+static const CalibrationPoint even[] = {
+    {0, 0}, {128, 25}, {256, 100}, {384, 225}, {512, 400}, {640, 625},
+    {768, 900}, {896, 1225}, {1024, 1600}
+};
+
+static const long ROUNDS = 20000;
+
+static void bench(const char *label, const CalibrationPoint *points, byte count) {
+    CalibrationCurve curve(points, count);
+    long sum = 0;
+    unsigned long long cycles = CYCLES();
+    unsigned long start = micros();
+    for (long r = 0; r < ROUNDS; r++) {
+        for (int raw = 0; raw < 1024; raw++) {
+            sum += curve.lookup(raw);
+        }
+    }
+    unsigned long took = micros() - start;
+    cycles = CYCLES() - cycles;
+    double lookups = (double) ROUNDS * 1024;
+    printf("%-8s %6.2f ns %6.1f cycles per lookup%s\n", label, took * 1000.0 / lookups, cycles / lookups, sum == 42 ? " " : "");
+}
+
+int main(void) {
+    bench("even", even, 9);
+    bench("uneven", thermistor, 9);
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include "gauge_config.h"
+
+// startup time: how long validate() and load() take for the default
+//  layout of example/runtime_layout, read from RAM and from the EEPROM.
+//  load() also init()s every component it adds, which for the 24 LED strip
+//  means a first show(): 720us of modeled wire time out of the total
+
+static const byte layout[124] = {
+  0x47, 0x46, 0x01, 0x02, 0x00, 0xaf, 0x00, 0xb8, 0x01, 0x0b, 0x02, 0x00,
+  0x28, 0x19, 0x00, 0x02, 0x00, 0xaf, 0x00, 0x9a, 0x01, 0x90, 0x01, 0x02,
+  0x02, 0x01, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x06,
+  0x00, 0x07, 0x00, 0x08, 0x00, 0x09, 0x00, 0x0a, 0x00, 0x0b, 0x00, 0x0c,
+  0x00, 0x0d, 0x00, 0x0e, 0x00, 0x0f, 0x00, 0x10, 0x00, 0x11, 0x00, 0x01,
+  0x11, 0x00, 0x01, 0x00, 0x00, 0x46, 0x00, 0x37, 0x00, 0x08, 0x01, 0x00,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x05, 0x00, 0x04,
+  0x00, 0x03, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x00, 0x17, 0x00, 0x16,
+  0x00, 0x15, 0x00, 0x14, 0x00, 0x13, 0x00, 0x12, 0x00, 0x01, 0x12, 0x00,
+  0x01, 0x02, 0x18, 0x00, 0x02, 0x00, 0x01, 0x01, 0x01, 0x3c, 0x00, 0xff,
+  0x00, 0x01, 0x0f, 0x69,
+};
+
+static const long ROUNDS = 20000;
+
+static void bench(const char *label, ConfigReader *reader) {
+    static byte buffer[2048];
+    Arena arena(buffer, sizeof(buffer));
+    GaugeConfig config(&arena);
+
+    unsigned long start = micros();
+    for (long r = 0; r < ROUNDS; r++) {
+        reader->rewind();
+        config.validate(reader);
+    }
+    double validateMicros = (double) (micros() - start) / ROUNDS;
+
+    unsigned long loadMicros = 0;
+    for (long r = 0; r < ROUNDS; r++) {
+        CompositeGauge gauge;
+        arena.reset();
+        reader->rewind();
+        config.load(reader, &gauge);
+        loadMicros += config.loadMicros;
+    }
+    printf("%-8s validate %6.2f us, load %6.2f us, %u arena bytes, error %d\n", label,
+        validateMicros, (double) loadMicros / ROUNDS, (unsigned) arena.getUsed(), config.error);
+}
+
+int main(void) {
+    MemoryConfigReader memory(layout, sizeof(layout));
+    bench("memory", &memory);
+
+    for (word i = 0; i < sizeof(layout); i++) {
+        EEPROM.write(16 + i, layout[i]);
+    }
+    EEPROMConfigReader stored(16, sizeof(layout));
+    bench("eeprom", &stored);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "datasource.h"
+#include "arena.h"
+
+// ns per sensor to turn MPX readings into pressure at 1, 8 and 64 sensors:
+//  MPXSensor::convert() alone, a whole MPXSensorBank tick (reads included)
+//  and the same sensors ticked one by one
+
+static const long SENSOR_ROUNDS = 4000000;
+
+static double nsPerSensor(unsigned long micros, long rounds, byte count) {
+    return micros * 1000.0 / rounds / count;
+}
+
+int main(void) {
+    printf("%8s %12s %12s %12s\n", "sensors", "convert ns", "bank ns", "one by one ns");
+    const byte counts[] = {1, 8, 64};
+    for (byte c = 0; c < sizeof(counts); c++) {
+        byte count = counts[c];
+        long rounds = SENSOR_ROUNDS / count;
+        Arena::framework()->reset();
+
+        vector<MPX5500Sensor> odd;
+        vector<MPX4250Sensor> even;
+        odd.reserve(count);
+        even.reserve(count);
+        MPXSensor *sensors[64];
+        for (byte i = 0; i < count; i++) {
+            stubAnalog[i & 15] = 300 + i;
+            if (i % 2) {
+                odd.emplace_back(i & 15, 40);
+                sensors[i] = &odd.back();
+            } else {
+                even.emplace_back(i & 15, 3);
+                sensors[i] = &even.back();
+            }
+        }
+        MPXSensorBank bank(sensors, count);
+        bank.init();
+
+        word raw[64];
+        int offsets[64], bases[64], kpaAbs[64];
+        long gains[64];
+        for (byte i = 0; i < count; i++) {
+            raw[i] = 300 + i;
+            offsets[i] = sensors[i]->getAdcValueOffset();
+            gains[i] = sensors[i]->getConversionGain();
+            bases[i] = sensors[i]->getConversionBase();
+        }
+
+        long sum = 0;
+        unsigned long start = micros();
+        for (long r = 0; r < rounds; r++) {
+            raw[0] = r & 1023;
+            MPXSensor::convert(raw, offsets, gains, bases, kpaAbs, count);
+            sum += kpaAbs[count - 1];
+        }
+        double convertNs = nsPerSensor(micros() - start, rounds, count);
+
+        start = micros();
+        for (long r = 0; r < rounds; r++) {
+            bank.tick();
+        }
+        double bankNs = nsPerSensor(micros() - start, rounds, count);
+
+        start = micros();
+        for (long r = 0; r < rounds; r++) {
+            for (byte i = 0; i < count; i++) {
+                sensors[i]->tick();
+            }
+        }
+        double singleNs = nsPerSensor(micros() - start, rounds, count);
+
+        printf("%8d %12.2f %12.2f %12.2f%s\n", count, convertNs, bankNs, singleNs, sum == 42 ? " " : "");
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "gauge_fw.h"
+#include "datasource.h"
+#include "display.h"
+#include "arena.h"
+
+// idle mode on a simulated clock: a boost gauge (one sensor, a 24 LED ring,
+//  720us on the wire per refresh) ticking every 10ms while the value moves
+//  and every 100ms once parked. Duty cycle of each phase, how long a
+//  refresh takes (wakeToUpdate), and how long a change made while parked
+//  takes to reach the ring, against the same gauge without idle mode
+
+static const unsigned long ACTIVE_INTERVAL = 10000;
+static const unsigned long IDLE_INTERVAL = 100000;
+static const word IDLE_AFTER = 50;
+static const unsigned long PHASE_MICROS = 10000000;
+
+class ManualSource : public SourceComponent {
+public:
+    int value = 0;
+    void init(void) {}
+    void tick(void) { this->read(); }
+    void read(void) { this->sampledAt = micros(); }
+    int raw(void) { return this->value; }
+    const char *unit(void) { return ""; }
+    void formatTo(char *buffer) { snprintf(buffer, FORMAT_SIZE, "%d", this->value); }
+};
+
+// ticks (and sleeps) for a phase, moving the value every tick or not at all
+static void run(CompositeGauge *gauge, ManualSource *source, bool moving, const char *label) {
+    gauge->resetDutyCycle();
+    unsigned long start = micros();
+    while (micros() - start < PHASE_MICROS) {
+        if (moving) {
+            source->value = (source->value + 3) % 100;
+        }
+        gauge->tick();
+        gauge->idle();
+    }
+    printf("%-22s duty %3d%%, wake to update %5luus\n", label, gauge->dutyCycle(), gauge->wakeToUpdate);
+}
+
+// changes made part way through an idle interval, how long until the
+//  ring shows them: the rest of the interval, then a refresh
+static void wakeLatency(CompositeGauge *gauge, ManualSource *source) {
+    LatencyHistogram latency;
+    for (int change = 0; change < 200; change++) {
+        // let it park again, idle() returns when the next tick is due
+        while (!gauge->isIdle()) {
+            gauge->tick();
+            gauge->idle();
+        }
+        gauge->tick();
+        stubAdvance(IDLE_INTERVAL * (change % 10) / 10);
+
+        unsigned long shows = Adafruit_NeoPixel::shows;
+        unsigned long changedAt = micros();
+        source->value = (source->value + 50) % 100;
+        while (Adafruit_NeoPixel::shows == shows) {
+            gauge->idle();
+            gauge->tick();
+        }
+        latency.record(micros() - changedAt);
+    }
+    latency.print(&Serial, "change while parked to ring");
+}
+
+int main(void) {
+    Arena::framework()->reset();
+    stubFakeClock(1000000);
+    vector<int> sweepLeds = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22};
+    vector<int> alertLeds = {23};
+    int base[3] = {25, 8, 0}, alert[3] = {255, 0, 0}, blank[3] = {0, 0, 0};
+
+    ManualSource source;
+    SingleSweepLEDStrip ring(&source, 6, 24, 0, 100, 90, base, blank, alert, &sweepLeds, &alertLeds);
+    CompositeGauge plain;
+    plain.add(&source);
+    plain.add(&ring);
+    run(&plain, &source, true, "no idle mode");
+
+    CompositeGauge gauge;
+    gauge.add(&source);
+    gauge.add(&ring);
+    gauge.setIdleMode(ACTIVE_INTERVAL, IDLE_INTERVAL, IDLE_AFTER);
+    run(&gauge, &source, true, "idle mode, moving");
+    run(&gauge, &source, false, "idle mode, parked");
+    wakeLatency(&gauge, &source);
+    stubRealClock();
+    return 0;
+}
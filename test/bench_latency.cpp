@@ -0,0 +1,74 @@
+#include "display.h"
+#include "arena.h"
+
+// sensor-to-output latency of a recorded boost trace replayed through a
+//  whole gauge: a 24 LED ring, a 2x30 LED bar with one sweep per side and
+//  a screen. Two seconds on the real clock (the strips' wire time is the
+//  stubs' 30us per LED), ticking flat out and then in idle mode at 10ms.
+//  Outputs later in the gauge wait for the earlier ones to be sent, and
+//  the bar only sends the strips that changed
+
+static const unsigned long RUN_MICROS = 2000000;
+
+// spool up, hold, lift off (tenths of kpa, one sample per 5ms)
+static const word boost[] = {
+    1000, 1000, 1050, 1120, 1210, 1330, 1460, 1590, 1700, 1790, 1850, 1880,
+    1900, 1900, 1890, 1900, 1910, 1900, 1700, 1400, 1150, 1020, 990, 1000
+};
+
+static void bench(bool idleMode) {
+    Arena::framework()->reset();
+    ReplaySensor replay(boost, sizeof(boost) / sizeof(boost[0]), 5000);
+
+    vector<int> ringLeds = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22};
+    vector<int> ringAlert = {23};
+    int base[3] = {25, 8, 0}, alert[3] = {255, 0, 0}, blank[3] = {0, 0, 0};
+    SingleSweepLEDStrip ring(&replay, 6, 24, 1000, 2000, 1880, base, blank, alert, &ringLeds, &ringAlert);
+
+    vector<int> leftLeds, rightLeds, noAlert;
+    for (int led = 0; led < 30; led++) {
+        leftLeds.push_back(led);
+        rightLeds.push_back(59 - led);
+    }
+    FullSweepIlluminationStrategy strategy;
+    IndAddrLEDStripSweep left(&replay, 1000, 2000, 1880, base, alert, blank, &leftLeds, &noAlert, &strategy);
+    IndAddrLEDStripSweep right(&replay, 1000, 2000, 1880, base, alert, blank, &rightLeds, &noAlert, &strategy);
+    IndAddrLEDStripSweep *sweeps[] = {&left, &right};
+    Adafruit_NeoPixel leftBar(30, 7), rightBar(30, 8);
+    vector<Adafruit_NeoPixel*> bars = {&leftBar, &rightBar};
+    MultiStripLEDOutput barOutput(&bars);
+    MultiSweepLEDStrip bar(sweeps, 2, &barOutput);
+
+    SingleDataSourceScreen screen(0x3C, &SH1106_128x64, &replay);
+
+    LatencyHistogram ringLatency, barLatency, screenLatency;
+    ring.setLatencyHistogram(&ringLatency);
+    bar.setLatencyHistogram(&barLatency);
+    screen.setLatencyHistogram(&screenLatency);
+
+    CompositeGauge gauge;
+    gauge.add(&replay);
+    gauge.add(&ring);
+    gauge.add(&bar);
+    gauge.add(&screen);
+    if (idleMode) {
+        gauge.setIdleMode(10000, 100000, 50);
+    }
+
+    unsigned long start = micros();
+    while (micros() - start < RUN_MICROS) {
+        gauge.tick();
+        gauge.idle();
+    }
+
+    printf("%s, duty %d%%\n", idleMode ? "idle mode at 10ms" : "flat out", gauge.dutyCycle());
+    ringLatency.print(&Serial, "  ring");
+    barLatency.print(&Serial, "  bar");
+    screenLatency.print(&Serial, "  screen");
+}
+
+int main(void) {
+    bench(false);
+    bench(true);
+    return 0;
+}
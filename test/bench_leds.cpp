@@ -0,0 +1,73 @@
+#include "display.h"
+#include "arena.h"
+
+// refresh time against LED count: the same LEDs on one strip, split over
+//  8 strips sent one after the other, and split over 8 strips sent in
+//  parallel. Every LED changes every frame, like a sweep moving fast.
+//
+// On a PC there's no wire: the stubs wait 30us per LED, and the host
+//  ParallelLEDOutput waits for the longest strip. So the refresh times
+//  below are that model plus a little overhead, and the flat parallel
+//  curve is what the model says RMT does, not a measurement of it. What
+//  is measured is the framework's own cost, the setLed() ns per LED
+
+static const int FRAMES = 20;
+static const byte STRIPS = 8;
+static const int SET_PASSES = 2000;
+
+static unsigned long frameMicros(LEDOutput *output, int leds, double *setLedNs) {
+    output->begin();
+    output->show();
+    unsigned long start = micros();
+    for (int frame = 0; frame < FRAMES; frame++) {
+        for (int led = 0; led < leds; led++) {
+            output->setLed(led, frame, led & 0xFF, 0);
+        }
+        output->show();
+    }
+    unsigned long frame = (micros() - start) / FRAMES;
+
+    start = micros();
+    for (int pass = 0; pass < SET_PASSES; pass++) {
+        for (int led = 0; led < leds; led++) {
+            output->setLed(led, pass, led & 0xFF, 0);
+        }
+    }
+    *setLedNs = (micros() - start) * 1000.0 / SET_PASSES / leds;
+    return frame;
+}
+
+int main(void) {
+    printf("%6s %12s %12s %12s %14s %14s %14s\n", "leds", "1 strip us", "8 serial us", "8 parallel us",
+        "1 setLed ns", "serial setLed", "parallel setLed");
+    for (int leds = 16; leds <= 512; leds *= 2) {
+        Arena::framework()->reset();
+
+        Adafruit_NeoPixel single(leds);
+        NeoPixelLEDOutput singleOutput(&single);
+
+        vector<Adafruit_NeoPixel*> strips;
+        word counts[STRIPS];
+        byte pins[STRIPS];
+        for (byte i = 0; i < STRIPS; i++) {
+            counts[i] = leds / STRIPS;
+            pins[i] = i;
+            strips.push_back(new Adafruit_NeoPixel(counts[i]));
+        }
+        MultiStripLEDOutput serialOutput(&strips);
+        ParallelLEDOutput parallelOutput(pins, counts, STRIPS);
+
+        double singleNs, serialNs, parallelNs;
+        unsigned long singleUs = frameMicros(&singleOutput, leds, &singleNs);
+        unsigned long serialUs = frameMicros(&serialOutput, leds, &serialNs);
+        unsigned long parallelUs = frameMicros(&parallelOutput, leds, &parallelNs);
+        printf("%6d %12lu %12lu %12lu %14.1f %14.1f %14.1f\n", leds,
+            singleUs, serialUs, parallelUs, singleNs, serialNs, parallelNs);
+
+        for (byte i = 0; i < STRIPS; i++) {
+            delete strips[i];
+        }
+    }
+    printf("(refresh times are the stubs' 30us per LED wire model, see above)\n");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "obd.h"
+
+// OBD polling against a SimulatedECU answering after 2ms, 4 PIDs: responses
+//  per second and request-to-response latency at 1, 2 and 4 requests in
+//  flight, over one simulated second with a tick every 100us. Then what a
+//  tick costs on this machine, with responses waiting to be read
+
+static const unsigned long ECU_DELAY = 2000;
+static const unsigned long TICK_MICROS = 100;
+static const long ROUNDS = 2000000;
+
+class FixedSource : public DataSource {
+public:
+    void init(void) {}
+    void read(void) {}
+    int raw(void) { return 50; }
+    void formatTo(char *buffer) {}
+    const char *unit(void) { return ""; }
+};
+
+static const byte pids[4] = {
+    OBDSource::PID_RPM, OBDSource::PID_INTAKE_PRESSURE, OBDSource::PID_COOLANT_TEMP, OBDSource::PID_THROTTLE
+};
+
+static void bench(byte maxInFlight) {
+    FixedSource value;
+    SimulatedECU ecu(ECU_DELAY);
+    OBDBus obd(&ecu, maxInFlight);
+    OBDSource sources[4] = {OBDSource(pids[0]), OBDSource(pids[1]), OBDSource(pids[2]), OBDSource(pids[3])};
+    for (byte i = 0; i < 4; i++) {
+        ecu.simulate(pids[i], &value);
+        obd.add(&sources[i]);
+    }
+    LatencyHistogram latency;
+    obd.setLatencyHistogram(&latency);
+    obd.init();
+
+    stubFakeClock(1000000, 0);
+    for (unsigned long t = 0; t < 1000000; t += TICK_MICROS) {
+        obd.tick();
+        stubAdvance(TICK_MICROS);
+    }
+    stubRealClock();
+    printf("in flight %d: %lu responses/s, %lu timeouts\n", maxInFlight, obd.responses, obd.timeouts);
+    latency.print(&Serial, "  latency");
+}
+
+int main(void) {
+    bench(1);
+    bench(2);
+    bench(4);
+
+    FixedSource value;
+    SimulatedECU ecu(0);
+    OBDBus obd(&ecu, 4);
+    OBDSource sources[4] = {OBDSource(pids[0]), OBDSource(pids[1]), OBDSource(pids[2]), OBDSource(pids[3])};
+    for (byte i = 0; i < 4; i++) {
+        ecu.simulate(pids[i], &value);
+        obd.add(&sources[i]);
+    }
+    obd.init();
+    unsigned long start = micros();
+    for (long r = 0; r < ROUNDS; r++) {
+        obd.tick();
+    }
+    printf("tick %.1f ns (%lu responses)\n", (micros() - start) * 1000.0 / ROUNDS, obd.responses);
+    return 0;
+}
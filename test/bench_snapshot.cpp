@@ -0,0 +1,101 @@
+#include "concurrent.h"
+#include "display.h"
+#include "arena.h"
+
+// cost of handing a value from the sampling core to the display core:
+//  publish() and load() alone, and load() while another thread publishes.
+//  Then a whole DualCoreGauge (a sensor, a 24 LED ring and a screen) with
+//  a thread per stage against both stages in sequence: ticks per second of
+//  each stage, and sensor-to-display latency. With a single CPU the two
+//  threads take turns, so the latency is mostly the scheduler's
+
+class CountingSource : public DataSource {
+    int count = 0;
+public:
+    void init(void) {}
+    void read(void) { this->sampledAt = ++this->count; }
+    int raw(void) { return this->count; }
+    const char *unit(void) { return ""; }
+    void formatTo(char *buffer) { snprintf(buffer, FORMAT_SIZE, "%d", this->count % 100000); }
+};
+
+static const long ROUNDS = 2000000;
+static volatile bool publishing;
+
+static void *publisher(void *snapshot) {
+    while (publishing) {
+        ((SnapshotSource*) snapshot)->publish();
+    }
+    return NULL;
+}
+
+static double nsPerLoad(SnapshotSource *snapshot) {
+    unsigned long start = micros();
+    long sum = 0;
+    for (long i = 0; i < ROUNDS; i++) {
+        sum += snapshot->raw();
+    }
+    return (micros() - start) * 1000.0 / ROUNDS + (sum == 42 ? 1 : 0);
+}
+
+static const unsigned long GAUGE_MICROS = 1000000;
+
+static void benchGauge(bool threads) {
+    Arena::framework()->reset();
+    DualCoreGauge gauge;
+    TestSensor sensor(175, 440, 3);
+    SnapshotSource snapshot(&sensor);
+    vector<int> sweepLeds = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22};
+    vector<int> alertLeds = {23};
+    int base[3] = {25, 8, 0}, alert[3] = {255, 0, 0}, blank[3] = {0, 0, 0};
+    SingleSweepLEDStrip ring(&snapshot, 6, 24, 175, 440, 400, base, blank, alert, &sweepLeds, &alertLeds);
+    SingleDataSourceScreen screen(0x3C, &SH1106_128x64, &snapshot);
+    LatencyHistogram ringLatency, screenLatency;
+    ring.setLatencyHistogram(&ringLatency);
+    screen.setLatencyHistogram(&screenLatency);
+    gauge.add(&sensor);
+    gauge.share(&snapshot);
+    gauge.add(&ring);
+    gauge.add(&screen);
+
+    unsigned long start = micros();
+    if (threads) {
+        gauge.init();
+        delay(GAUGE_MICROS / 1000);
+        gauge.stop();
+    } else {
+        while (micros() - start < GAUGE_MICROS) {
+            gauge.tick();
+        }
+    }
+    double seconds = (micros() - start) / 1000000.0;
+
+    printf("%s: sampling %.0f ticks/s, display %.0f ticks/s\n", threads ? "threads" : "sequence",
+        gauge.samplingTicks / seconds, gauge.displayTicks / seconds);
+    ringLatency.print(&Serial, "  ring");
+    screenLatency.print(&Serial, "  screen");
+}
+
+int main(void) {
+    CountingSource source;
+    SnapshotSource snapshot(&source);
+
+    unsigned long start = micros();
+    for (long i = 0; i < ROUNDS; i++) {
+        source.read();
+        snapshot.publish();
+    }
+    printf("publish                %6.1f ns\n", (micros() - start) * 1000.0 / ROUNDS);
+    printf("load                   %6.1f ns\n", nsPerLoad(&snapshot));
+
+    publishing = true;
+    pthread_t thread;
+    pthread_create(&thread, NULL, &publisher, &snapshot);
+    printf("load while publishing  %6.1f ns\n", nsPerLoad(&snapshot));
+    publishing = false;
+    pthread_join(thread, NULL);
+
+    benchGauge(false);
+    benchGauge(true);
+    return 0;
+}
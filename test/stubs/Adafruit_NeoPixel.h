@@ -0,0 +1,33 @@
+#ifndef ADAFRUIT_NEOPIXEL_STUB_H
+ #define ADAFRUIT_NEOPIXEL_STUB_H
+
+#include "Arduino.h"
+
+typedef uint16_t neoPixelType;
+#define NEO_GRB 1
+#define NEO_KHZ800 0
+
+// the real show() bit-bangs 24 bits at 800kHz per LED with interrupts off,
+//  the stub blocks for that long too so benchmarks see the wire time (or
+//  moves the fake clock by that much, see stubFakeClock())
+class Adafruit_NeoPixel {
+    uint16_t count;
+    uint32_t *pixels;
+    uint8_t brightness = 0;
+public:
+    static unsigned long shows;
+    Adafruit_NeoPixel(uint16_t count, int16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800);
+    void begin(void) {}
+    void show(void);
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+    void setPixelColor(uint16_t n, uint32_t c);
+    uint32_t getPixelColor(uint16_t n) const;
+    void setBrightness(uint8_t b);
+    uint8_t getBrightness(void) const { return brightness - 1; }
+    uint16_t numPixels(void) const { return count; }
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+        return ((uint32_t) r << 16) | ((uint32_t) g << 8) | b;
+    }
+};
+
+#endif
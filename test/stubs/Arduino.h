@@ -0,0 +1,99 @@
+#ifndef ARDUINO_STUB_H
+ #define ARDUINO_STUB_H
+
+// just enough of the Arduino core to build and run the framework on a PC,
+//  ARDUINO is left undefined so the framework picks its host code paths
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+#define PROGMEM
+#define F(x) x
+inline uint8_t pgm_read_byte(const void *p) { return *(const uint8_t*) p; }
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#ifndef constrain
+ #define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+unsigned long micros(void);
+unsigned long millis(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+// a simulated clock for the tests: after stubFakeClock(), micros() only
+//  moves with delay(), delayMicroseconds() and stubAdvance(), plus 'step'
+//  us each time it's read so busy waits still come to an end
+void stubFakeClock(unsigned long start, unsigned long step = 1);
+void stubRealClock(void);
+void stubAdvance(unsigned long us);
+bool stubClockIsFake(void);
+
+// analogRead(pin) returns stubAnalog[pin], set it from the tests
+extern int stubAnalog[16];
+int analogRead(uint8_t pin);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+void noInterrupts(void);
+void interrupts(void);
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer);
+
+class String {
+public:
+    std::string s;
+    String() {}
+    String(const char *c) : s(c) {}
+    String(int value) : s(std::to_string(value)) {}
+    void toCharArray(char *buffer, unsigned int size) const {
+        strncpy(buffer, s.c_str(), size);
+        buffer[size - 1] = 0;
+    }
+    const char *c_str(void) const { return s.c_str(); }
+    unsigned int length(void) const { return s.size(); }
+};
+
+class Print {
+public:
+    virtual size_t write(uint8_t c) = 0;
+    size_t print(const char *s);
+    size_t print(const String &s);
+    size_t print(unsigned long value);
+    size_t print(long value);
+    size_t print(int value);
+    size_t println(const char *s);
+    size_t println(unsigned long value);
+    size_t println(void);
+};
+
+class Stream : public Print {};
+
+class HardwareSerial : public Stream {
+public:
+    size_t write(uint8_t c);
+    void begin(long baud);
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef EEPROM_STUB_H
+ #define EEPROM_STUB_H
+
+#include "Arduino.h"
+
+class EEPROMClass {
+public:
+    uint8_t data[4096];
+    uint8_t read(int address) { return data[address]; }
+    void write(int address, uint8_t value) { data[address] = value; }
+    void begin(size_t size) {}
+    void commit(void) {}
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
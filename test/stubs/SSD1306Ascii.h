@@ -0,0 +1,29 @@
+#ifndef SSD1306ASCII_STUB_H
+ #define SSD1306ASCII_STUB_H
+
+#include "Arduino.h"
+
+struct DevType {
+    uint8_t lcdWidth;
+    uint8_t lcdHeight;
+};
+
+extern const DevType SH1106_128x64, Adafruit128x64, Adafruit128x32;
+extern const uint8_t X11fixed7x14B[], font5x7[];
+
+// what gets printed is kept in `written`, a '|' marks each home()
+class SSD1306Ascii : public Print {
+public:
+    std::string written;
+    size_t write(uint8_t c);
+    void reset(uint8_t pin) {}
+    void clear(void) {}
+    void setFont(const uint8_t *font) {}
+    void set1X(void) {}
+    void set2X(void) {}
+    void setCol(uint8_t col) {}
+    void setRow(uint8_t row) {}
+    void home(void);
+};
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef SSD1306ASCIIWIRE_STUB_H
+ #define SSD1306ASCIIWIRE_STUB_H
+
+#include "SSD1306Ascii.h"
+
+class SSD1306AsciiWire : public SSD1306Ascii {
+public:
+    void begin(const DevType *dev, uint8_t address) {}
+};
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef WIRE_STUB_H
+ #define WIRE_STUB_H
+
+class TwoWire {
+public:
+    void begin(void);
+};
+
+extern TwoWire Wire;
+
+#endif
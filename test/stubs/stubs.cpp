@@ -0,0 +1,182 @@
+#include <chrono>
+#include <thread>
+#include "Arduino.h"
+#include "Adafruit_NeoPixel.h"
+#include "Wire.h"
+#include "SSD1306Ascii.h"
+#include "EEPROM.h"
+
+static std::chrono::steady_clock::time_point bootedAt = std::chrono::steady_clock::now();
+static bool fakeClock = false;
+static unsigned long fakeNow = 0;
+static unsigned long fakeStep = 0;
+
+unsigned long micros(void) {
+    if (fakeClock) {
+        fakeNow += fakeStep;
+        return fakeNow;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - bootedAt).count();
+}
+
+unsigned long millis(void) {
+    return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+    if (fakeClock) {
+        fakeNow += ms * 1000;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    if (fakeClock) {
+        fakeNow += us;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void stubFakeClock(unsigned long start, unsigned long step) {
+    fakeClock = true;
+    fakeNow = start;
+    fakeStep = step;
+}
+
+void stubRealClock(void) {
+    fakeClock = false;
+}
+
+void stubAdvance(unsigned long us) {
+    fakeNow += us;
+}
+
+bool stubClockIsFake(void) {
+    return fakeClock;
+}
+
+void yield(void) {}
+
+int stubAnalog[16];
+
+int analogRead(uint8_t pin) {
+    return stubAnalog[pin & 15];
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+int digitalRead(uint8_t pin) { return LOW; }
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode) {}
+void detachInterrupt(uint8_t interrupt) {}
+void noInterrupts(void) {}
+void interrupts(void) {}
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer) {
+    sprintf(buffer, "%*.*f", width, precision, value);
+    return buffer;
+}
+
+size_t Print::print(const char *s) {
+    size_t n = 0;
+    while (*s) {
+        n += write(*s++);
+    }
+    return n;
+}
+
+size_t Print::print(const String &s) { return print(s.c_str()); }
+size_t Print::print(unsigned long value) { return print(std::to_string(value).c_str()); }
+size_t Print::print(long value) { return print(std::to_string(value).c_str()); }
+size_t Print::print(int value) { return print(std::to_string(value).c_str()); }
+size_t Print::println(const char *s) { return print(s) + println(); }
+size_t Print::println(unsigned long value) { return print(value) + println(); }
+size_t Print::println(void) { return write('\n'); }
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+void HardwareSerial::begin(long baud) {}
+
+HardwareSerial Serial;
+
+
+
+unsigned long Adafruit_NeoPixel::shows = 0;
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t count, int16_t pin, neoPixelType type) {
+    this->count = count;
+    // malloc() like the library, so it isn't counted as the framework's
+    this->pixels = (uint32_t*) calloc(count, sizeof(uint32_t));
+}
+
+void Adafruit_NeoPixel::show(void) {
+    unsigned long wireTime = this->count * 30UL;
+    if (stubClockIsFake()) {
+        stubAdvance(wireTime);
+    } else {
+        unsigned long start = micros();
+        while (micros() - start < wireTime) {}
+    }
+    shows++;
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+    this->setPixelColor(n, Color(r, g, b));
+}
+
+// same as the library: the color is scaled when stored, so reading it
+//  back after setBrightness() doesn't give the same color
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
+    if (n >= this->count) {
+        return;
+    }
+    if (this->brightness) {
+        uint8_t r = ((c >> 16 & 0xFF) * this->brightness) >> 8;
+        uint8_t g = ((c >> 8 & 0xFF) * this->brightness) >> 8;
+        uint8_t b = ((c & 0xFF) * this->brightness) >> 8;
+        c = Color(r, g, b);
+    }
+    this->pixels[n] = c;
+}
+
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
+    if (n >= this->count) {
+        return 0;
+    }
+    uint32_t c = this->pixels[n];
+    if (this->brightness) {
+        uint8_t r = ((c >> 16 & 0xFF) << 8) / this->brightness;
+        uint8_t g = ((c >> 8 & 0xFF) << 8) / this->brightness;
+        uint8_t b = ((c & 0xFF) << 8) / this->brightness;
+        c = Color(r, g, b);
+    }
+    return c;
+}
+
+void Adafruit_NeoPixel::setBrightness(uint8_t b) {
+    this->brightness = b + 1;
+}
+
+
+
+TwoWire Wire;
+void TwoWire::begin(void) {}
+
+const DevType SH1106_128x64 = {128, 64}, Adafruit128x64 = {128, 64}, Adafruit128x32 = {128, 32};
+const uint8_t X11fixed7x14B[1] = {0}, font5x7[1] = {0};
+
+size_t SSD1306Ascii::write(uint8_t c) {
+    if (this->written.size() > 1024) {
+        this->written.clear();
+    }
+    this->written.push_back(c);
+    return 1;
+}
+
+void SSD1306Ascii::home(void) {
+    this->written.push_back('|');
+}
+
+EEPROMClass EEPROM;
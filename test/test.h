@@ -0,0 +1,27 @@
+#ifndef GAUGE_TEST_H
+ #define GAUGE_TEST_H
+
+#include <stdio.h>
+
+// bare bones checks, a test program exits with the number of failed checks
+
+static int testFailures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        testFailures++; \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+    } \
+} while (0)
+
+#define CHECK_EQUAL(expected, actual) do { \
+    long e = (long) (expected), a = (long) (actual); \
+    if (e != a) { \
+        testFailures++; \
+        printf("%s:%d: expected %s == %ld, got %ld\n", __FILE__, __LINE__, #actual, e, a); \
+    } \
+} while (0)
+
+#define TEST_RESULT() (printf("%s: %s\n", __FILE__, testFailures ? "FAILED" : "ok"), testFailures)
+
+#endif
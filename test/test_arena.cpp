@@ -0,0 +1,125 @@
+#include "arena.h"
+#include "calibration.h"
+#include "display.h"
+#include "test.h"
+
+/**
+ * Print that keeps what's printed
+ */
+class StringPrint : public Print {
+public:
+    std::string text;
+    size_t write(uint8_t c) {
+        this->text += (char) c;
+        return 1;
+    }
+};
+
+// allocations are aligned, the high water mark survives reset() and
+//  what doesn't fit is counted instead of handed out
+static void testAllocate(void) {
+    byte buffer[64 + Arena::ALIGNMENT];
+    Arena arena(buffer + 1, 64);
+    byte *first = (byte*) arena.allocate(3);
+    void *second = arena.allocate(8);
+    CHECK(first != NULL && second != NULL);
+    CHECK_EQUAL(0, (uintptr_t) first % Arena::ALIGNMENT);
+    CHECK_EQUAL(0, (uintptr_t) second % Arena::ALIGNMENT);
+    CHECK((byte*) second >= first + 3);
+
+    size_t used = arena.getUsed();
+    CHECK_EQUAL(used, arena.getHighWaterMark());
+    CHECK(arena.allocate(64) == NULL);
+    CHECK_EQUAL(1, arena.getFailures());
+    CHECK_EQUAL(used, arena.getUsed());
+
+    arena.reset();
+    CHECK_EQUAL(0, arena.getUsed());
+    CHECK_EQUAL(used, arena.getHighWaterMark());
+    CHECK(arena.allocate(16) != NULL);
+    CHECK_EQUAL(used, arena.getHighWaterMark());
+    CHECK_EQUAL(1, arena.getFailures());
+}
+
+static void testReport(void) {
+    byte buffer[64];
+    Arena arena(buffer, sizeof(buffer));
+    arena.allocate(40);
+    arena.reset();
+    arena.allocate(16);
+    arena.allocate(100);
+    StringPrint out;
+    arena.report(&out, "arena");
+    CHECK(out.text == "arena: 16/64 bytes, high water mark 40, failed allocations 1\n");
+}
+
+static int difference(int *values, byte count) {
+    return values[0] - values[1];
+}
+
+static const CalibrationPoint table[] = {{0, 0}, {1023, 100}};
+
+// with the framework arena full, components that need memory from it
+//  are refused by the gauge instead of sitting there doing nothing, and
+//  the failures show up in the report
+static void testFullArenaRefused(void) {
+    Arena *arena = Arena::framework();
+    arena->reset();
+    arena->allocate(arena->getSize() - arena->getUsed());
+    word failures = arena->getFailures();
+
+    CompositeGauge gauge;
+    TestSensor a(0, 100, 1), b(0, 100, 1);
+    CHECK(gauge.add(&a));
+    CHECK(gauge.add(&b));
+
+    vector<int> leds = {0, 1, 2};
+    int color[3] = {1, 1, 1};
+    SingleSweepLEDStrip ring(&a, 6, 3, 0, 100, 90, color, color, color, &leds, &leds);
+    CHECK(!ring.isReady());
+    CHECK(!gauge.add(&ring));
+
+    vector<DataSource*> inputs = {&a, &b};
+    DerivedSource delta(&inputs, &difference);
+    CHECK(!gauge.add(&delta));
+
+    MPX4250Sensor boost(0);
+    MPXSensor *sensors[] = {&boost};
+    MPXSensorBank bank(sensors, 1);
+    CHECK(!gauge.add(&bank));
+
+    CalibrationCurve curve(table, 2);
+    CalibratedSensor level(1, &curve);
+    CHECK(!curve.isValid());
+    CHECK(!gauge.add(&level));
+
+    const byte pins[] = {2};
+    const word counts[] = {8};
+    ParallelLEDOutput output(pins, counts, 1);
+    vector<IndAddrLEDStripSweep*> sweeps;
+    MultiSweepLEDStrip strip(&sweeps, &output);
+    CHECK(!output.isReady());
+    CHECK(!gauge.add(&strip));
+
+    LatencyHistogram histogram;
+    CHECK(!strip.setLatencyHistogram(&histogram));
+
+    CHECK_EQUAL(2, gauge.getComponentCount());
+    CHECK(arena->getFailures() > failures);
+    StringPrint out;
+    arena->report(&out, "arena");
+    CHECK(out.text.find("failed allocations 0") == std::string::npos);
+
+    // the same components fit once there's room
+    arena->reset();
+    SingleSweepLEDStrip roomy(&a, 6, 3, 0, 100, 90, color, color, color, &leds, &leds);
+    CHECK(gauge.add(&roomy));
+    arena->reset();
+}
+
+int main(void) {
+    testAllocate();
+    testReport();
+    testFullArenaRefused();
+    return TEST_RESULT();
+}
@@ -0,0 +1,172 @@
+#include <math.h>
+#include "calibration.h"
+#include "datasource.h"
+#include "arena.h"
+#include "test.h"
+
+static const CalibrationPoint thermistor[] = {{100, 1500}, {200, 1100}, {350, 800}, {600, 500}, {900, 200}};
+static const CalibrationPoint even[] = {{0, 0}, {256, 100}, {512, 400}, {768, 900}, {1024, 1600}};
+
+/**
+ * Reference: the same interpolation in floating point
+ */
+static double interpolate(const CalibrationPoint *points, byte count, int raw) {
+    if (raw <= points[0].raw) {
+        return points[0].value;
+    }
+    for (byte i = 1; i < count; i++) {
+        if (raw <= points[i].raw) {
+            double t = (double) (raw - points[i - 1].raw) / (points[i].raw - points[i - 1].raw);
+            return points[i - 1].value + t * (points[i].value - points[i - 1].value);
+        }
+    }
+    return points[count - 1].value;
+}
+
+// every raw level of the ADC is within one unit of the exact curve, and
+//  the table points themselves are exact
+static void checkCurve(const CalibrationPoint *points, byte count) {
+    CalibrationCurve curve(points, count);
+    CHECK(curve.isValid());
+    double worst = 0;
+    for (int raw = -10; raw <= 1033; raw++) {
+        double error = fabs(curve.lookup(raw) - interpolate(points, count, raw));
+        worst = error > worst ? error : worst;
+    }
+    CHECK(worst <= 1.0);
+    for (byte i = 0; i < count; i++) {
+        CHECK_EQUAL(points[i].value, curve.lookup(points[i].raw));
+    }
+}
+
+static void testLookupAccuracy(void) {
+    checkCurve(thermistor, 5);
+    checkCurve(even, 5);
+}
+
+static void testInvalidTables(void) {
+    const CalibrationPoint unsorted[] = {{100, 0}, {50, 10}};
+    const CalibrationPoint repeated[] = {{100, 0}, {100, 10}};
+    CHECK(!CalibrationCurve(unsorted, 2).isValid());
+    CHECK(!CalibrationCurve(repeated, 2).isValid());
+    CHECK(!CalibrationCurve(thermistor, 1).isValid());
+    CHECK_EQUAL(0, CalibrationCurve(unsorted, 2).lookup(500));
+}
+
+// a sensor with a curve that didn't compile never shows raw counts as
+//  if they were calibrated
+static void testInvalidCurveSensor(void) {
+    const CalibrationPoint unsorted[] = {{100, 0}, {50, 10}};
+    CalibrationCurve curve(unsorted, 2);
+    stubAnalog[4] = 500;
+    CalibratedSensor sensor(4, &curve, "C", 10);
+    CHECK(!sensor.isReady());
+    sensor.init();
+    sensor.tick();
+    CHECK_EQUAL(0, sensor.raw());
+    CHECK_EQUAL(0UL, sensor.getSampledAt());
+    CHECK(strcmp("  ---", sensor.format().c_str()) == 0);
+
+    CalibrationCurve good(thermistor, 5);
+    CalibratedSensor working(4, &good, "C", 10);
+    CHECK(working.isReady());
+    working.tick();
+    CHECK_EQUAL(620, working.raw());
+    CHECK(working.getSampledAt() != 0);
+    CHECK(strcmp(" 62.0", working.format().c_str()) == 0);
+}
+
+// char is unsigned on the ESP (and in this build), a negative offset
+//  must survive auto zero
+static void testAutoZeroNegativeOffset(void) {
+    stubAnalog[5] = 300;
+    MPX4250Sensor sensor(5);
+    sensor.setAutoZero(8);
+    sensor.init();
+    CHECK(!sensor.isZeroClamped());
+    CHECK_EQUAL(-26, sensor.getAdcValueOffset());
+
+    char formatted[DataSource::FORMAT_SIZE];
+    sensor.tick();
+    sensor.formatTo(formatted);
+    CHECK(fabs(atof(formatted)) < 0.05);
+}
+
+// calibrating a sensor in a bank takes effect on the next bank tick
+static void testBankedCalibrateZero(void) {
+    Arena::framework()->reset();
+    stubAnalog[6] = 300;
+    MPX4250Sensor sensor(6);
+    MPXSensor *sensors[] = {&sensor};
+    MPXSensorBank bank(sensors, 1);
+    bank.init();
+    bank.tick();
+    CHECK(sensor.raw() == 300);
+    char before[DataSource::FORMAT_SIZE];
+    sensor.formatTo(before);
+
+    CHECK(sensor.calibrateZero(4));
+    bank.tick();
+    char after[DataSource::FORMAT_SIZE];
+    sensor.formatTo(after);
+    CHECK(strcmp(before, after) != 0);
+    CHECK(fabs(atof(after)) < 0.05);
+    Arena::framework()->reset();
+}
+
+// banked sensors show the same values as sensors ticked on their own
+static void testBankMatchesSensors(void) {
+    Arena::framework()->reset();
+    stubAnalog[8] = 420;
+    stubAnalog[9] = 150;
+    MPX4250Sensor alone(8, 5), banked(8, 5);
+    MPX5500Sensor aloneDelta(9), bankedDelta(9);
+    MPXSensor *sensors[] = {&banked, &bankedDelta};
+    MPXSensorBank bank(sensors, 2);
+    alone.init();
+    aloneDelta.init();
+    bank.init();
+    CHECK_EQUAL(0UL, banked.getSampledAt());
+
+    alone.tick();
+    aloneDelta.tick();
+    bank.tick();
+    CHECK_EQUAL(420, banked.raw());
+    CHECK_EQUAL(150, bankedDelta.raw());
+    CHECK(banked.getSampledAt() != 0);
+    CHECK_EQUAL(banked.getSampledAt(), bankedDelta.getSampledAt());
+    CHECK(strcmp(alone.format().c_str(), banked.format().c_str()) == 0);
+    CHECK(strcmp(aloneDelta.format().c_str(), bankedDelta.format().c_str()) == 0);
+
+    stubAnalog[8] = 600;
+    bank.tick();
+    alone.tick();
+    CHECK_EQUAL(600, banked.raw());
+    CHECK(strcmp(alone.format().c_str(), banked.format().c_str()) == 0);
+    Arena::framework()->reset();
+}
+
+// an offset that doesn't fit is reported, not clamped quietly
+static void testClampReported(void) {
+    stubAnalog[7] = 900;
+    MPX4250Sensor sensor(7);
+    sensor.init();
+    CHECK(!sensor.calibrateZero(4));
+    CHECK(sensor.isZeroClamped());
+    CHECK_EQUAL(127, sensor.getAdcValueOffset());
+
+    stubAnalog[7] = 300;
+    CHECK(sensor.calibrateZero(4));
+    CHECK(!sensor.isZeroClamped());
+}
+
+int main(void) {
+    testLookupAccuracy();
+    testInvalidTables();
+    testInvalidCurveSensor();
+    testAutoZeroNegativeOffset();
+    testBankedCalibrateZero();
+    testBankMatchesSensors();
+    testClampReported();
+    return TEST_RESULT();
+}
@@ -0,0 +1,159 @@
+#include "gauge_fw.h"
+#include "datasource.h"
+#include "arena.h"
+#include "test.h"
+
+/**
+ * Source set by hand, counting how often its depth is asked for
+ */
+class ManualSource : public SourceComponent {
+public:
+    int value = 0;
+    unsigned long depthAsked = 0;
+    void init(void) {}
+    void tick(void) { this->read(); }
+    void read(void) { this->sampledAt = micros(); }
+    int raw(void) { return this->value; }
+    const char *unit(void) { return ""; }
+    void formatTo(char *buffer) { snprintf(buffer, FORMAT_SIZE, "%d", this->value); }
+    byte getSourceDepth(void) { this->depthAsked++; return 0; }
+};
+
+// remembers what its source showed when it was ticked
+class RecordingSink : public GaugeComponent {
+public:
+    DataSource *source;
+    int shown = 0;
+    RecordingSink(DataSource *source) { this->source = source; }
+    void init(void) {}
+    void tick(void) { this->shown = this->source->raw(); }
+};
+
+static int difference(int *values, byte count) {
+    return values[0] - values[1];
+}
+
+static int sum(int *values, byte count) {
+    int total = 0;
+    for (byte i = 0; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+// the inputs are combined once per tick, the result is as old as the
+//  oldest input
+static void testCombines(void) {
+    Arena::framework()->reset();
+    stubFakeClock(1000000);
+    ManualSource boost, backpressure;
+    vector<DataSource*> inputs = {&boost, &backpressure};
+    DerivedSource delta(&inputs, difference, "psi", 10);
+    boost.value = 150;
+    backpressure.value = 40;
+    boost.read();
+    stubAdvance(500);
+    backpressure.read();
+    stubAdvance(500);
+    delta.tick();
+    CHECK_EQUAL(110, delta.raw());
+    CHECK_EQUAL(boost.getSampledAt(), delta.getSampledAt());
+    CHECK(strcmp(" 11.0", delta.format().c_str()) == 0);
+    CHECK(strcmp("psi", delta.unit()) == 0);
+
+    // cached until the next tick
+    boost.value = 0;
+    CHECK_EQUAL(110, delta.raw());
+    stubRealClock();
+    Arena::framework()->reset();
+}
+
+// whatever order they're added in, inputs are ticked before what they
+//  feed, and sinks see this tick's values
+static void testAddOrder(void) {
+    Arena::framework()->reset();
+    ManualSource low, high;
+    vector<DataSource*> firstInputs = {&low, &high};
+    DerivedSource first(&firstInputs, sum);
+    vector<DataSource*> secondInputs = {&first, &low};
+    DerivedSource second(&secondInputs, difference);
+    RecordingSink sink(&second);
+
+    CompositeGauge gauge;
+    CHECK(gauge.add(&sink));
+    CHECK(gauge.add(&second));
+    CHECK(gauge.add(&first));
+    CHECK(gauge.add(&high));
+    CHECK(gauge.add(&low));
+    CHECK_EQUAL(0, low.getDepth());
+    CHECK_EQUAL(1, first.getDepth());
+    CHECK_EQUAL(2, second.getDepth());
+
+    low.value = 5;
+    high.value = 7;
+    gauge.tick();
+    CHECK_EQUAL(12, first.raw());
+    CHECK_EQUAL(7, second.raw());
+    CHECK_EQUAL(7, sink.shown);
+    Arena::framework()->reset();
+}
+
+// a source feeding itself, even through others, is refused instead of
+//  recursing forever
+static void testCycle(void) {
+    Arena::framework()->reset();
+    ManualSource low;
+    vector<DataSource*> firstInputs = {&low, NULL};
+    vector<DataSource*> secondInputs = {NULL};
+    DerivedSource first(&firstInputs, sum), second(&secondInputs, sum);
+    firstInputs[1] = &second;
+    secondInputs[0] = &first;
+
+    CHECK_EQUAL(DerivedSource::DEPTH_CYCLE, first.getSourceDepth());
+    CHECK_EQUAL(DerivedSource::DEPTH_CYCLE, second.getSourceDepth());
+    CHECK(!first.isReady());
+    CompositeGauge gauge;
+    CHECK(!gauge.add(&first));
+    CHECK(!gauge.add(&second));
+    CHECK(gauge.add(&low));
+    Arena::framework()->reset();
+}
+
+// the depth is worked out once, however deep the nesting and however
+//  often the gauge asks
+static void testDepthComputedOnce(void) {
+    Arena::framework()->reset();
+    ManualSource input;
+    // each level reads the previous one twice
+    static const byte LEVELS = 12;
+    vector<DataSource*> inputs[LEVELS];
+    DerivedSource *levels[LEVELS];
+    for (byte i = 0; i < LEVELS; i++) {
+        DataSource *previous = i == 0 ? (DataSource*) &input : levels[i - 1];
+        inputs[i].push_back(previous);
+        inputs[i].push_back(previous);
+        levels[i] = Arena::framework()->make<DerivedSource>(&inputs[i], sum);
+    }
+
+    CompositeGauge gauge;
+    CHECK(gauge.add(levels[LEVELS - 1]));
+    CHECK(gauge.add(&input));
+    CHECK_EQUAL(LEVELS, levels[LEVELS - 1]->getDepth());
+    unsigned long asked = input.depthAsked;
+    CHECK(asked <= 4);
+
+    gauge.setIdleMode(0, 0, 5);
+    for (byte i = 0; i < 100; i++) {
+        gauge.tick();
+    }
+    CHECK_EQUAL(asked, input.depthAsked);
+    Arena::framework()->reset();
+}
+
+int main(void) {
+    testCombines();
+    testAddOrder();
+    testCycle();
+    testDepthComputedOnce();
+    return TEST_RESULT();
+}
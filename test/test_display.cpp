@@ -0,0 +1,105 @@
+#include "display.h"
+#include "arena.h"
+#include "test.h"
+
+// only the strips with a changed LED are sent again, with and without
+//  the brightness set
+static void testMultiStripSkipsUnchanged(void) {
+    Adafruit_NeoPixel a(4), b(4);
+    vector<Adafruit_NeoPixel*> strips;
+    strips.push_back(&a);
+    strips.push_back(&b);
+    MultiStripLEDOutput output(&strips);
+    output.begin();
+    output.show();
+
+    for (int brightness = 255; brightness > 0; brightness -= 51) {
+        a.setBrightness(brightness);
+        b.setBrightness(brightness);
+        output.setLed(5, 200, 100, 3);
+        output.show();
+        unsigned long shows = Adafruit_NeoPixel::shows;
+        output.setLed(5, 200, 100, 3);
+        output.setLed(1, a.getPixelColor(1) >> 16, a.getPixelColor(1) >> 8 & 0xFF, a.getPixelColor(1) & 0xFF);
+        output.show();
+        CHECK_EQUAL(shows, Adafruit_NeoPixel::shows);
+
+        output.setLed(2, 255, 255, 255);
+        output.show();
+        CHECK_EQUAL(shows + 1, Adafruit_NeoPixel::shows);
+        output.setLed(2, 0, 0, 0);
+    }
+}
+
+// LEDs are numbered across the strips, and strips without a buffer or
+//  channel drop their LEDs instead of writing somewhere else
+static void testParallelNumbering(void) {
+    Arena::framework()->reset();
+    const byte pins[] = {2, 4, 5};
+    const word counts[] = {3, 5, 2};
+    ParallelLEDOutput output(pins, counts, 3);
+    output.begin();
+    CHECK_EQUAL(3, output.getReadyStrips());
+    // LED n gets red n+1, green 100+n, blue 200+n; 10 and 11 are past the end
+    for (int led = 0; led < 12; led++) {
+        output.setLed(led, led + 1, 100 + led, 200 + led);
+    }
+    output.show();
+
+    int led = 0;
+    for (byte strip = 0; strip < 3; strip++) {
+        const byte *pixels = output.getPixels(strip);
+        for (word i = 0; i < counts[strip]; i++, led++) {
+            CHECK_EQUAL(100 + led, pixels[i * 3]);
+            CHECK_EQUAL(led + 1, pixels[i * 3 + 1]);
+            CHECK_EQUAL(200 + led, pixels[i * 3 + 2]);
+        }
+    }
+    CHECK_EQUAL(10, led);
+    CHECK(output.getPixels(3) == NULL);
+
+    // a strip that didn't get its buffer drops its LEDs, the others keep theirs
+    Arena::framework()->reset();
+    // leave 80 bytes: the two arrays of 3 pointers and longs, 16 for the
+    //  first strip (aligned), 15 for the second and nothing for the third
+    Arena::framework()->allocate(Arena::framework()->getSize() - 80);
+    ParallelLEDOutput starved(pins, counts, 3);
+    starved.begin();
+    CHECK(!starved.isReady());
+    CHECK_EQUAL(2, starved.getReadyStrips());
+    CHECK(starved.getPixels(2) == NULL);
+    for (int led = 0; led < 12; led++) {
+        starved.setLed(led, 9, 9, 9);
+    }
+    CHECK_EQUAL(9, starved.getPixels(1)[4 * 3]);
+    Arena::framework()->reset();
+}
+
+// the refresh takes as long as the longest strip, not the sum of them. On
+//  the fake clock, so only the modeled wire time counts and not how busy
+//  the PC is
+static void testParallelShowTime(void) {
+    Arena::framework()->reset();
+    stubFakeClock(1000000);
+    const byte pins[] = {2, 4, 5, 12};
+    const word counts[] = {60, 60, 60, 60};
+    ParallelLEDOutput output(pins, counts, 4);
+    output.begin();
+    output.show();
+    stubAdvance(ParallelLEDOutput::LATCH_MICROS);
+    unsigned long start = micros();
+    output.show();
+    unsigned long took = micros() - start;
+    CHECK(took >= 60 * 30);
+    // one strip's time plus the clock reads, four in a row would be 7200us
+    CHECK(took < 60 * 30 + 20);
+    stubRealClock();
+    Arena::framework()->reset();
+}
+
+int main(void) {
+    testMultiStripSkipsUnchanged();
+    testParallelNumbering();
+    testParallelShowTime();
+    return TEST_RESULT();
+}
@@ -0,0 +1,241 @@
+#include "gauge_config.h"
+#include "test.h"
+
+static unsigned long allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    void *pointer = malloc(size);
+    if (pointer == NULL) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void *pointer, size_t size) noexcept {
+    free(pointer);
+}
+
+// the default layout of example/runtime_layout: two MPX sensors, two
+//  sweeps on one strip and a dual screen
+static const byte layout[124] = {
+  0x47, 0x46, 0x01, 0x02, 0x00, 0xaf, 0x00, 0xb8, 0x01, 0x0b, 0x02, 0x00,
+  0x28, 0x19, 0x00, 0x02, 0x00, 0xaf, 0x00, 0x9a, 0x01, 0x90, 0x01, 0x02,
+  0x02, 0x01, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x06,
+  0x00, 0x07, 0x00, 0x08, 0x00, 0x09, 0x00, 0x0a, 0x00, 0x0b, 0x00, 0x0c,
+  0x00, 0x0d, 0x00, 0x0e, 0x00, 0x0f, 0x00, 0x10, 0x00, 0x11, 0x00, 0x01,
+  0x11, 0x00, 0x01, 0x00, 0x00, 0x46, 0x00, 0x37, 0x00, 0x08, 0x01, 0x00,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x05, 0x00, 0x04,
+  0x00, 0x03, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x00, 0x17, 0x00, 0x16,
+  0x00, 0x15, 0x00, 0x14, 0x00, 0x13, 0x00, 0x12, 0x00, 0x01, 0x12, 0x00,
+  0x01, 0x02, 0x18, 0x00, 0x02, 0x00, 0x01, 0x01, 0x01, 0x3c, 0x00, 0xff,
+  0x00, 0x01, 0x0f, 0x69,
+};
+
+/**
+ * Writes a description with 'sensors' test sensors, one sweep on the
+ *  first one lighting LEDs 0 to 'lastLed', shown on a strip of 'stripLeds'
+ *  and 'sweeps' copies of that sweep; returns its length
+ */
+static word describe(byte *out, byte sensors, word stripLeds, word lastLed, byte sweeps = 1) {
+    word length = 0;
+    const byte header[] = {GaugeConfig::MAGIC_0, GaugeConfig::MAGIC_1, GaugeConfig::VERSION};
+    memcpy(out, header, 3);
+    length += 3;
+    out[length++] = sensors;
+    for (byte i = 0; i < sensors; i++) {
+        const byte sensor[] = {GaugeConfig::SENSOR_TEST, 0xaf, 0x00, 0xb8, 0x01, 0x0b};
+        memcpy(out + length, sensor, sizeof(sensor));
+        length += sizeof(sensor);
+    }
+    out[length++] = sweeps;
+    for (byte i = 0; i < sweeps; i++) {
+        const byte sweep[] = {0, 0, 0, 100, 0, 90, 0, 1, 1, 1, 255, 0, 0, 0, 0, 0, GaugeConfig::STRATEGY_FULL_SWEEP, 0};
+        memcpy(out + length, sweep, sizeof(sweep));
+        length += sizeof(sweep);
+        out[length++] = lastLed + 1;
+        for (word led = 0; led <= lastLed; led++) {
+            out[length++] = led & 0xFF;
+            out[length++] = led >> 8;
+        }
+        out[length++] = 0;
+    }
+    out[length++] = 1;
+    out[length++] = 6;
+    out[length++] = stripLeds & 0xFF;
+    out[length++] = stripLeds >> 8;
+    out[length++] = sweeps;
+    for (byte i = 0; i < sweeps; i++) {
+        out[length++] = i;
+    }
+    out[length++] = 0;
+    byte checksum = 0;
+    for (word i = 0; i < length; i++) {
+        checksum += out[i];
+    }
+    out[length++] = checksum;
+    return length;
+}
+
+static void testLoad(void) {
+    byte buffer[4096];
+    Arena arena(buffer, sizeof(buffer));
+    GaugeConfig config(&arena);
+    CompositeGauge gauge;
+    MemoryConfigReader reader(layout, sizeof(layout));
+
+    // the sweeps keep their LEDs in the arena, nothing comes from the heap
+    unsigned long before = allocations;
+    CHECK(config.load(&reader, &gauge));
+    CHECK_EQUAL(before, allocations);
+    CHECK_EQUAL(GaugeConfig::ERROR_NONE, config.error);
+    CHECK_EQUAL(2, config.getSourceCount());
+    CHECK_EQUAL(4, gauge.getComponentCount());
+    CHECK(arena.getUsed() > 0);
+}
+
+// a description that turns out bad at the very end builds nothing
+static void testBadChecksumBuildsNothing(void) {
+    byte buffer[4096];
+    Arena arena(buffer, sizeof(buffer));
+    GaugeConfig config(&arena);
+    CompositeGauge gauge;
+    byte corrupt[sizeof(layout)];
+    memcpy(corrupt, layout, sizeof(layout));
+    corrupt[sizeof(layout) - 1]++;
+    MemoryConfigReader reader(corrupt, sizeof(corrupt));
+
+    CHECK(!config.load(&reader, &gauge));
+    CHECK_EQUAL(GaugeConfig::ERROR_CHECKSUM, config.error);
+    CHECK_EQUAL(0, gauge.getComponentCount());
+    CHECK_EQUAL(0, arena.getUsed());
+    CHECK_EQUAL(0, arena.getFailures());
+}
+
+// too small an arena is found out before anything is built, and the
+//  same config can load another description into what's left
+static void testArenaTooSmallBuildsNothing(void) {
+    byte buffer[4096];
+    Arena arena(buffer, sizeof(buffer));
+    arena.allocate(sizeof(buffer) - 200);
+    size_t used = arena.getUsed();
+    GaugeConfig config(&arena);
+    CompositeGauge gauge;
+    MemoryConfigReader reader(layout, sizeof(layout));
+
+    CHECK(!config.load(&reader, &gauge));
+    CHECK_EQUAL(GaugeConfig::ERROR_ARENA_FULL, config.error);
+    CHECK_EQUAL(0, gauge.getComponentCount());
+    CHECK_EQUAL(used, arena.getUsed());
+
+    arena.reset();
+    MemoryConfigReader again(layout, sizeof(layout));
+    CHECK(config.load(&again, &gauge));
+    CHECK_EQUAL(4, gauge.getComponentCount());
+}
+
+/**
+ * Placeholder taking up a slot of the gauge
+ */
+class Filler : public GaugeComponent {
+public:
+    void init(void) {}
+    void tick(void) {}
+};
+
+// a layout with more components than the gauge has room for is refused
+//  whole, instead of losing the ones that don't fit
+static void testGaugeFull(void) {
+    byte buffer[4096];
+    Arena arena(buffer, sizeof(buffer));
+    GaugeConfig config(&arena);
+    CompositeGauge gauge;
+    Filler fillers[CompositeGauge::MAX_COMPONENTS];
+    for (byte i = 0; i < CompositeGauge::MAX_COMPONENTS - 3; i++) {
+        gauge.add(&fillers[i]);
+    }
+    MemoryConfigReader reader(layout, sizeof(layout));
+
+    CHECK(!config.load(&reader, &gauge));
+    CHECK_EQUAL(GaugeConfig::ERROR_GAUGE_FULL, config.error);
+    CHECK_EQUAL(CompositeGauge::MAX_COMPONENTS - 3, gauge.getComponentCount());
+    CHECK_EQUAL(0, arena.getUsed());
+
+    // with one more slot free it fits exactly
+    CompositeGauge roomier;
+    for (byte i = 0; i < CompositeGauge::MAX_COMPONENTS - 4; i++) {
+        roomier.add(&fillers[i]);
+    }
+    MemoryConfigReader again(layout, sizeof(layout));
+    CHECK(config.load(&again, &roomier));
+    CHECK_EQUAL(CompositeGauge::MAX_COMPONENTS, roomier.getComponentCount());
+}
+
+// validating another description doesn't change what getSource() sees
+//  of the gauge that was loaded
+static void testValidateKeepsLoaded(void) {
+    byte buffer[4096];
+    Arena arena(buffer, sizeof(buffer));
+    GaugeConfig config(&arena);
+    CompositeGauge gauge;
+    byte small[256], large[256];
+    MemoryConfigReader smallReader(small, describe(small, 2, 24, 11));
+    MemoryConfigReader largeReader(large, describe(large, 5, 24, 11));
+
+    CHECK(config.load(&smallReader, &gauge));
+    DataSource *first = config.getSource(0);
+    DataSource *second = config.getSource(1);
+    CHECK(first != NULL && second != NULL);
+
+    CHECK(config.validate(&largeReader));
+    CHECK_EQUAL(2, config.getSourceCount());
+    CHECK(config.getSource(0) == first);
+    CHECK(config.getSource(1) == second);
+    CHECK(config.getSource(4) == NULL);
+}
+
+// every LED a sweep lights has to be on the strip showing it
+static void testLedPastStrip(void) {
+    byte buffer[4096];
+    Arena arena(buffer, sizeof(buffer));
+    GaugeConfig config(&arena);
+    CompositeGauge gauge;
+    byte description[256];
+
+    MemoryConfigReader fits(description, describe(description, 1, 24, 23));
+    CHECK(config.validate(&fits));
+
+    MemoryConfigReader past(description, describe(description, 1, 24, 24));
+    CHECK(!config.load(&past, &gauge));
+    CHECK_EQUAL(GaugeConfig::ERROR_LED, config.error);
+    CHECK_EQUAL(0, gauge.getComponentCount());
+    CHECK_EQUAL(0, arena.getUsed());
+}
+
+static void testTooManySweeps(void) {
+    byte buffer[4096];
+    Arena arena(buffer, sizeof(buffer));
+    GaugeConfig config(&arena);
+    byte description[1024];
+
+    MemoryConfigReader most(description, describe(description, 1, 24, 3, GaugeConfig::MAX_SWEEPS));
+    CHECK(config.validate(&most));
+    MemoryConfigReader tooMany(description, describe(description, 1, 24, 3, GaugeConfig::MAX_SWEEPS + 1));
+    CHECK(!config.validate(&tooMany));
+    CHECK_EQUAL(GaugeConfig::ERROR_TOO_MANY_SWEEPS, config.error);
+}
+
+int main(void) {
+    testLoad();
+    testValidateKeepsLoaded();
+    testLedPastStrip();
+    testTooManySweeps();
+    testBadChecksumBuildsNothing();
+    testArenaTooSmallBuildsNothing();
+    testGaugeFull();
+    return TEST_RESULT();
+}
@@ -0,0 +1,181 @@
+#include "gauge_fw.h"
+#include "datasource.h"
+#include "display.h"
+#include "arena.h"
+#include "test.h"
+
+/**
+ * Source set by hand
+ */
+class ManualSource : public SourceComponent {
+public:
+    int value = 0;
+    void init(void) {}
+    void tick(void) { this->read(); }
+    void read(void) { this->sampledAt = micros(); }
+    int raw(void) { return this->value; }
+    const char *unit(void) { return ""; }
+    void formatTo(char *buffer) { snprintf(buffer, FORMAT_SIZE, "%d", this->value); }
+};
+
+class CountingSink : public GaugeComponent {
+public:
+    unsigned long ticks = 0;
+    void init(void) {}
+    void tick(void) { this->ticks++; }
+};
+
+// ticks enough times for the gauge to go idle, returns how many times
+//  the sink was refreshed meanwhile
+static unsigned long settle(CompositeGauge *gauge, CountingSink *sink, ManualSource *moving) {
+    unsigned long before = sink->ticks;
+    for (byte i = 0; i < 20; i++) {
+        if (moving != NULL) {
+            moving->value++;
+        }
+        gauge->tick();
+    }
+    return sink->ticks - before;
+}
+
+// without watch(), any source moving keeps the displays refreshing
+static void testUnwatchedSourcesKeepDisplaysAlive(void) {
+    CompositeGauge gauge;
+    ManualSource still, moving;
+    CountingSink sink;
+    gauge.add(&still);
+    gauge.add(&moving);
+    gauge.add(&sink);
+    gauge.setIdleMode(0, 0, 5);
+
+    CHECK_EQUAL(20, settle(&gauge, &sink, &moving));
+    CHECK(!gauge.isIdle());
+
+    settle(&gauge, &sink, NULL);
+    CHECK(gauge.isIdle());
+    CHECK_EQUAL(0, settle(&gauge, &sink, NULL));
+
+    // the one that was still moves now: refreshed right away, and awake
+    unsigned long before = sink.ticks;
+    still.value = 7;
+    gauge.tick();
+    CHECK_EQUAL(before + 1, sink.ticks);
+    CHECK(!gauge.isIdle());
+}
+
+// with watch(), only the watched sources count
+static void testWatchedOnly(void) {
+    CompositeGauge gauge;
+    ManualSource watched, other;
+    CountingSink sink;
+    gauge.add(&watched);
+    gauge.add(&other);
+    gauge.add(&sink);
+    gauge.watch(&watched, 0);
+    gauge.setIdleMode(0, 0, 5);
+
+    settle(&gauge, &sink, &other);
+    CHECK(gauge.isIdle());
+    CHECK_EQUAL(20, settle(&gauge, &sink, &watched));
+}
+
+// a gauge with no sources of its own never idles its displays
+static void testNoSources(void) {
+    CompositeGauge gauge;
+    CountingSink sink;
+    gauge.add(&sink);
+    gauge.setIdleMode(0, 0, 5);
+    CHECK_EQUAL(20, settle(&gauge, &sink, NULL));
+    CHECK(!gauge.isIdle());
+}
+
+// on the fake clock, with a 24 LED ring (720us on the wire per refresh):
+//  idle() sleeps until the next tick, the duty cycle follows what the
+//  gauge does, and a change while parked shows within one idle interval
+static void testIdleSimulation(void) {
+    Arena::framework()->reset();
+    stubFakeClock(1000000);
+    CompositeGauge gauge;
+    ManualSource source;
+    vector<int> sweepLeds = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22};
+    vector<int> alertLeds = {23};
+    int base[3] = {25, 8, 0}, alert[3] = {255, 0, 0}, blank[3] = {0, 0, 0};
+    SingleSweepLEDStrip ring(&source, 6, 24, 0, 100, 90, base, blank, alert, &sweepLeds, &alertLeds);
+    gauge.add(&source);
+    gauge.add(&ring);
+    gauge.setIdleMode(10000, 100000, 10);
+
+    // moving: a tick (and a refresh) every 10ms
+    unsigned long start = micros();
+    for (byte i = 0; i < 50; i++) {
+        source.value = i * 2;
+        gauge.tick();
+        gauge.idle();
+    }
+    unsigned long took = micros() - start;
+    CHECK(took >= 49 * 10000UL && took <= 50 * 10000UL + 1000);
+    CHECK(gauge.wakeToUpdate >= 24 * 30 && gauge.wakeToUpdate < 24 * 30 + 100);
+    CHECK(gauge.dutyCycle() >= 7 && gauge.dutyCycle() <= 8);
+
+    // parked: a tick every 100ms, and nothing to refresh
+    for (byte i = 0; i < 20; i++) {
+        gauge.tick();
+        gauge.idle();
+    }
+    CHECK(gauge.isIdle());
+    gauge.resetDutyCycle();
+    unsigned long shows = Adafruit_NeoPixel::shows;
+    start = micros();
+    for (byte i = 0; i < 20; i++) {
+        gauge.tick();
+        gauge.idle();
+    }
+    took = micros() - start;
+    CHECK(took >= 19 * 100000UL && took <= 20 * 100000UL + 1000);
+    CHECK_EQUAL(shows, Adafruit_NeoPixel::shows);
+    CHECK_EQUAL(0, gauge.dutyCycle());
+
+    // a change 40ms into an idle interval is on the ring at the next tick
+    gauge.tick();
+    stubAdvance(40000);
+    unsigned long changedAt = micros();
+    source.value = 50;
+    while (Adafruit_NeoPixel::shows == shows) {
+        gauge.idle();
+        gauge.tick();
+    }
+    unsigned long latency = micros() - changedAt;
+    CHECK(latency >= 60000 + 24 * 30 && latency <= 60000 + 24 * 30 + 100);
+    CHECK(!gauge.isIdle());
+    stubRealClock();
+    Arena::framework()->reset();
+}
+
+// without idle mode the gauge ticks flat out, and is measured all the same
+static void testDutyCycleWithoutIdleMode(void) {
+    stubFakeClock(1000000);
+    CompositeGauge gauge;
+    ManualSource source;
+    CountingSink sink;
+    gauge.add(&source);
+    gauge.add(&sink);
+    gauge.resetDutyCycle();
+    for (byte i = 0; i < 10; i++) {
+        gauge.tick();
+        delayMicroseconds(100);
+    }
+    // the stub clock steps 1us per read: about 2us busy out of every 102
+    CHECK(gauge.wakeToUpdate > 0);
+    CHECK(gauge.dutyCycle() >= 1 && gauge.dutyCycle() <= 3);
+    CHECK_EQUAL(10UL, sink.ticks);
+    stubRealClock();
+}
+
+int main(void) {
+    testUnwatchedSourcesKeepDisplaysAlive();
+    testWatchedOnly();
+    testNoSources();
+    testIdleSimulation();
+    testDutyCycleWithoutIdleMode();
+    return TEST_RESULT();
+}
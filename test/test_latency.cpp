@@ -0,0 +1,161 @@
+#include "latency.h"
+#include "display.h"
+#include "arena.h"
+#include "test.h"
+
+class TracedOutput : public LatencyTraced {
+public:
+    void show(byte output, unsigned long sampledAt) {
+        this->trace(output, sampledAt);
+    }
+};
+
+/**
+ * Source with a sample time set by hand
+ */
+class FixedSource : public DataSource {
+public:
+    void init(void) {}
+    void read(void) {}
+    int raw(void) { return 1; }
+    const char *unit(void) { return "u"; }
+    void formatTo(char *buffer) { strcpy(buffer, "1"); }
+    void sample(unsigned long at) { this->sampledAt = at; }
+};
+
+// a sample shown many times is counted once per output
+static void testOncePerSample(void) {
+    LatencyHistogram histogram;
+    TracedOutput output;
+    output.setLatencyHistogram(&histogram);
+
+    unsigned long sampledAt = micros();
+    for (byte i = 0; i < 5; i++) {
+        output.show(0, sampledAt);
+        output.show(1, sampledAt);
+    }
+    CHECK_EQUAL(2, histogram.count);
+
+    output.show(0, sampledAt + 1);
+    output.show(0, sampledAt + 1);
+    CHECK_EQUAL(3, histogram.count);
+
+    // outputs past MAX_TRACED aren't counted at all
+    output.show(LatencyTraced::MAX_TRACED, sampledAt + 2);
+    CHECK_EQUAL(3, histogram.count);
+}
+
+// sources that were never sampled don't add the time since boot
+static void testNeverSampled(void) {
+    LatencyHistogram histogram;
+    TracedOutput output;
+    output.setLatencyHistogram(&histogram);
+    output.show(0, 0);
+    output.show(1, 0);
+    CHECK_EQUAL(0, histogram.count);
+    CHECK_EQUAL(0, histogram.maxLatency);
+}
+
+// a screen refreshing the same sample counts it once
+static void testScreen(void) {
+    LatencyHistogram histogram;
+    FixedSource source;
+    SingleDataSourceScreen screen(0x3C, &Adafruit128x64, &source);
+    screen.setLatencyHistogram(&histogram);
+    screen.init();
+
+    for (byte i = 0; i < 10; i++) {
+        screen.tick();
+    }
+    CHECK_EQUAL(0, histogram.count);
+
+    source.sample(micros());
+    for (byte i = 0; i < 10; i++) {
+        screen.tick();
+    }
+    CHECK_EQUAL(1, histogram.count);
+    CHECK(histogram.maxLatency < 100000);
+}
+
+// a recording played back one sample per interval, then over again
+static void testReplaySensor(void) {
+    stubFakeClock(1000000, 0);
+    const word samples[] = {100, 200, 300};
+    ReplaySensor replay(samples, 3, 10000);
+    replay.init();
+    replay.tick();
+    CHECK_EQUAL(100, replay.raw());
+    unsigned long sampledAt = replay.getSampledAt();
+    CHECK_EQUAL(1000000UL, sampledAt);
+    CHECK(strcmp(" 10.0", replay.format().c_str()) == 0);
+
+    stubAdvance(5000);
+    replay.tick();
+    CHECK_EQUAL(100, replay.raw());
+    CHECK_EQUAL(sampledAt, replay.getSampledAt());
+
+    const int expected[] = {200, 300, 100, 200};
+    for (byte i = 0; i < 4; i++) {
+        stubAdvance(5000);
+        replay.tick();
+        CHECK_EQUAL(expected[i], replay.raw());
+        stubAdvance(5000);
+    }
+    stubRealClock();
+}
+
+// a recording replayed through sweeps into LED strips: every sample is
+//  traced once per sweep, and never faster than the strip's wire time
+static void testReplayThroughStrips(void) {
+    Arena::framework()->reset();
+    stubFakeClock(1000000);
+    const word samples[] = {0, 250, 500, 750, 1000, 750, 500, 250};
+    ReplaySensor replay(samples, 8, 20000);
+    vector<int> ringLeds = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22};
+    vector<int> ringAlert = {23};
+    vector<int> leftLeds = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, rightLeds = {19, 18, 17, 16, 15, 14, 13, 12, 11, 10};
+    vector<int> noAlert;
+    int base[3] = {25, 8, 0}, alert[3] = {255, 0, 0}, blank[3] = {0, 0, 0};
+    SingleSweepLEDStrip ring(&replay, 6, 24, 0, 1000, 900, base, blank, alert, &ringLeds, &ringAlert);
+    FullSweepIlluminationStrategy strategy;
+    IndAddrLEDStripSweep left(&replay, 0, 1000, 2000, base, alert, blank, &leftLeds, &noAlert, &strategy);
+    IndAddrLEDStripSweep right(&replay, 0, 1000, 2000, base, alert, blank, &rightLeds, &noAlert, &strategy);
+    IndAddrLEDStripSweep *sweeps[] = {&left, &right};
+    Adafruit_NeoPixel bar(20);
+    NeoPixelLEDOutput barOutput(&bar);
+    MultiSweepLEDStrip barStrip(sweeps, 2, &barOutput);
+
+    LatencyHistogram ringLatency, barLatency;
+    CHECK(ring.setLatencyHistogram(&ringLatency));
+    CHECK(barStrip.setLatencyHistogram(&barLatency));
+    CompositeGauge gauge;
+    CHECK(gauge.add(&ring));
+    CHECK(gauge.add(&barStrip));
+    CHECK(gauge.add(&replay));
+
+    // 400ms, a tick every 2ms: 20 samples
+    unsigned long start = micros();
+    while (micros() - start < 400000) {
+        unsigned long tickAt = micros();
+        gauge.tick();
+        // the next tick 2ms after this one started
+        stubAdvance(2000 - (micros() - tickAt));
+    }
+    CHECK_EQUAL(20UL, ringLatency.count);
+    CHECK_EQUAL(40UL, barLatency.count);
+    // the ring goes first: its wire time, the bar waits for the ring too
+    CHECK(ringLatency.maxLatency >= 24 * 30 && ringLatency.maxLatency < 24 * 30 + 100);
+    CHECK(barLatency.average() >= (24 + 20) * 30 && barLatency.maxLatency < (24 + 20) * 30 + 100);
+    CHECK(bar.getPixelColor(0) != 0);
+    stubRealClock();
+    Arena::framework()->reset();
+}
+
+int main(void) {
+    testOncePerSample();
+    testNeverSampled();
+    testScreen();
+    testReplaySensor();
+    testReplayThroughStrips();
+    return TEST_RESULT();
+}
@@ -0,0 +1,205 @@
+#include "obd.h"
+#include "test.h"
+
+// a CAN driver that never starts, like a TWAI controller without transceiver
+class DeadCanBus : public CanBus {
+public:
+    int sends = 0;
+    bool begin(void) { return false; }
+    bool send(const CanFrame *frame) { this->sends++; return true; }
+    bool receive(CanFrame *frame) { return false; }
+};
+
+static void testFailedBegin(void) {
+    DeadCanBus can;
+    OBDBus obd(&can);
+    OBDSource rpm(OBDSource::PID_RPM);
+    obd.add(&rpm);
+    obd.init();
+    CHECK(!obd.isOnline());
+    for (byte i = 0; i < 10; i++) {
+        obd.tick();
+    }
+    CHECK_EQUAL(0, can.sends);
+    CHECK_EQUAL(0UL, obd.requests);
+}
+
+// what the simulated engine reports
+class FixedSource : public DataSource {
+public:
+    int value;
+    FixedSource(int value) : DataSource() { this->value = value; }
+    void init(void) {}
+    void read(void) {}
+    int raw(void) { return this->value; }
+    void formatTo(char *buffer) {}
+    const char *unit(void) { return ""; }
+};
+
+static void testSimulatedECU(void) {
+    stubFakeClock(1000000);
+    FixedSource engine(800), coolant(-25), load(37);
+    SimulatedECU ecu(2000);
+    ecu.simulate(OBDSource::PID_RPM, &engine);
+    ecu.simulate(OBDSource::PID_COOLANT_TEMP, &coolant);
+    ecu.simulate(OBDSource::PID_ENGINE_LOAD, &load);
+    OBDBus obd(&ecu);
+    OBDSource rpm(OBDSource::PID_RPM), temperature(OBDSource::PID_COOLANT_TEMP), engineLoad(OBDSource::PID_ENGINE_LOAD);
+    obd.add(&rpm);
+    obd.add(&temperature);
+    obd.add(&engineLoad);
+    obd.init();
+    CHECK(obd.isOnline());
+    for (byte i = 0; i < 20; i++) {
+        obd.tick();
+        delay(1);
+    }
+    CHECK_EQUAL(800, rpm.raw());
+    CHECK_EQUAL(-25, temperature.raw());
+    CHECK_EQUAL(37, engineLoad.raw());
+    CHECK(rpm.getSampledAt() != 0);
+    CHECK(obd.responses >= 3);
+    CHECK_EQUAL(0UL, obd.timeouts);
+
+    engine.value = 3250;
+    for (byte i = 0; i < 20; i++) {
+        obd.tick();
+        delay(1);
+    }
+    CHECK_EQUAL(3250, rpm.raw());
+    stubRealClock();
+}
+
+// never more than maxInFlight requests wait for the ECU at once
+static void testPipelining(void) {
+    stubFakeClock(1000000);
+    FixedSource value(50);
+    SimulatedECU ecu(10000);
+    OBDSource sources[4] = {
+        OBDSource(OBDSource::PID_RPM), OBDSource(OBDSource::PID_SPEED),
+        OBDSource(OBDSource::PID_THROTTLE), OBDSource(OBDSource::PID_INTAKE_PRESSURE)
+    };
+    OBDBus obd(&ecu, 2);
+    for (byte i = 0; i < 4; i++) {
+        ecu.simulate(sources[i].getPid(), &value);
+        obd.add(&sources[i]);
+    }
+    obd.init();
+
+    obd.tick();
+    CHECK_EQUAL(2UL, obd.requests);
+    for (byte i = 0; i < 5; i++) {
+        delay(1);
+        obd.tick();
+    }
+    // still waiting on the first two
+    CHECK_EQUAL(2UL, obd.requests);
+    CHECK_EQUAL(0UL, obd.responses);
+
+    delay(6);
+    obd.tick();
+    // both answered, the other two asked in their place
+    CHECK_EQUAL(2UL, obd.responses);
+    CHECK_EQUAL(4UL, obd.requests);
+    CHECK_EQUAL(50, sources[0].raw());
+    CHECK_EQUAL(50, sources[1].raw());
+    CHECK_EQUAL(0, sources[2].raw());
+
+    OBDBus wide(&ecu, 4);
+    for (byte i = 0; i < 4; i++) {
+        wide.add(&sources[i]);
+    }
+    wide.init();
+    wide.tick();
+    CHECK_EQUAL(4UL, wide.requests);
+    stubRealClock();
+}
+
+// an ECU that doesn't answer a PID, then stops answering at all
+static void testTimeouts(void) {
+    stubFakeClock(1000000);
+    FixedSource value(90);
+    SimulatedECU ecu(100);
+    ecu.simulate(OBDSource::PID_SPEED, &value);
+    OBDSource speed(OBDSource::PID_SPEED), unknown(OBDSource::PID_THROTTLE);
+    OBDBus obd(&ecu, 2, 1000);
+    obd.add(&speed);
+    obd.add(&unknown);
+    obd.init();
+
+    // speed keeps answering, so the bus stays online
+    for (byte i = 0; i < 50; i++) {
+        obd.tick();
+        delay(1);
+    }
+    CHECK(obd.timeouts >= OBDBus::OFFLINE_TIMEOUTS);
+    CHECK(obd.isOnline());
+    CHECK_EQUAL(90, speed.raw());
+
+    OBDBus silent(&ecu, 2, 1000);
+    silent.add(&unknown);
+    silent.init();
+    for (byte i = 0; i < OBDBus::OFFLINE_TIMEOUTS; i++) {
+        silent.tick();
+        CHECK(silent.isOnline());
+        delay(2);
+        silent.tick();
+    }
+    CHECK_EQUAL((unsigned long) OBDBus::OFFLINE_TIMEOUTS, silent.timeouts);
+    CHECK(!silent.isOnline());
+
+    // still asking, and back online with the first answer
+    ecu.simulate(OBDSource::PID_THROTTLE, &value);
+    unsigned long requests = silent.requests;
+    for (byte i = 0; i < 5; i++) {
+        silent.tick();
+        delay(1);
+    }
+    CHECK(silent.requests > requests);
+    CHECK(silent.isOnline());
+    CHECK_EQUAL(90, unknown.raw());
+    stubRealClock();
+}
+
+static void checkRoundTrip(byte pid, int from, int to) {
+    byte data[8];
+    int failures = 0;
+    for (int value = from; value <= to; value++) {
+        byte length = OBDSource::encode(pid, value, data);
+        if (OBDSource::decode(pid, data, length) != value) {
+            failures++;
+        }
+    }
+    CHECK_EQUAL(0, failures);
+}
+
+static void testEncodeDecode(void) {
+    checkRoundTrip(OBDSource::PID_COOLANT_TEMP, -40, 215);
+    checkRoundTrip(OBDSource::PID_INTAKE_TEMP, -40, 215);
+    checkRoundTrip(OBDSource::PID_ENGINE_LOAD, 0, 100);
+    checkRoundTrip(OBDSource::PID_THROTTLE, 0, 100);
+    checkRoundTrip(OBDSource::PID_RPM, 0, 16383);
+    checkRoundTrip(OBDSource::PID_SPEED, 0, 255);
+    checkRoundTrip(OBDSource::PID_INTAKE_PRESSURE, 0, 255);
+
+    // known answers: 0x1A 0xF8 is 1726 rpm, 0x00 is -40C
+    const byte rpm[2] = {0x1A, 0xF8}, cold[1] = {0x00};
+    CHECK_EQUAL(1726, OBDSource::decode(OBDSource::PID_RPM, rpm, 2));
+    CHECK_EQUAL(-40, OBDSource::decode(OBDSource::PID_COOLANT_TEMP, cold, 1));
+
+    // out of range values are clamped, not wrapped
+    byte data[8];
+    OBDSource::encode(OBDSource::PID_COOLANT_TEMP, -60, data);
+    CHECK_EQUAL(0, data[0]);
+    OBDSource::encode(OBDSource::PID_RPM, 20000, data);
+    CHECK_EQUAL(16383, OBDSource::decode(OBDSource::PID_RPM, data, 2));
+}
+
+int main(void) {
+    testFailedBegin();
+    testSimulatedECU();
+    testPipelining();
+    testTimeouts();
+    testEncodeDecode();
+    return TEST_RESULT();
+}
@@ -0,0 +1,186 @@
+#include "pulse.h"
+#include "test.h"
+
+// 2 pulses per revolution
+static const unsigned long RPM_SCALE = 60000000UL / 2;
+
+// runs the generator and the sensor on the fake clock for 'duration' us,
+//  one tick of both every 'tickEvery' us, like the gauge would
+static void run(PulseTrainGenerator *generator, SourceComponent *sensor, unsigned long duration, unsigned long tickEvery) {
+    for (unsigned long t = 0; t < duration; t += tickEvery) {
+        stubAdvance(tickEvery);
+        generator->tick();
+        sensor->tick();
+    }
+}
+
+// from idle to redline, whether the gauge ticks faster or slower than
+//  the pulses come
+static void testSteadySignal(void) {
+    const long rpms[] = {600, 3000, 7000, 10000};
+    const unsigned long tickEvery[] = {500, 20000};
+    for (byte t = 0; t < 2; t++) {
+        for (byte i = 0; i < 4; i++) {
+            stubFakeClock(1000000, 0);
+            FrequencySensor tach(PulseInput::NO_PIN, RPM_SCALE);
+            PulseTrainGenerator generator(&tach, RPM_SCALE / rpms[i]);
+            tach.init();
+            generator.init();
+            run(&generator, &tach, 200000, tickEvery[t]);
+            CHECK(abs(tach.raw() - rpms[i]) <= rpms[i] / 100);
+        }
+    }
+    stubRealClock();
+}
+
+// the first edge only starts counting
+static void testFirstEdge(void) {
+    stubFakeClock(1000000, 0);
+    FrequencySensor tach(PulseInput::NO_PIN, RPM_SCALE);
+    PulseTrainGenerator generator(&tach, 10000);
+    generator.init();
+    generator.tick();
+    tach.tick();
+    CHECK_EQUAL(0, tach.raw());
+    run(&generator, &tach, 30000, 1000);
+    CHECK_EQUAL(3000, tach.raw());
+    stubRealClock();
+}
+
+// after the signal stops, the value drops to 0 and the stall isn't
+//  averaged into the period when it comes back
+static void testResumeAfterTimeout(void) {
+    stubFakeClock(1000000, 0);
+    FrequencySensor tach(PulseInput::NO_PIN, RPM_SCALE, "rpm", 20000);
+    unsigned long period = RPM_SCALE / 10000;
+    PulseTrainGenerator generator(&tach, period);
+    generator.init();
+    run(&generator, &tach, 10000, 1000);
+    CHECK(abs(tach.raw() - 10000) <= 100);
+
+    generator.setPeriod(0);
+    run(&generator, &tach, 60000, 1000);
+    CHECK_EQUAL(0, tach.raw());
+
+    generator.setPeriod(period);
+    for (byte i = 0; i < 10; i++) {
+        run(&generator, &tach, 1000, 1000);
+        CHECK(tach.raw() == 0 || abs(tach.raw() - 10000) <= 100);
+    }
+    CHECK(abs(tach.raw() - 10000) <= 100);
+    stubRealClock();
+}
+
+// a rate past what fits in raw() is clamped, not wrapped
+static void testClamp(void) {
+    stubFakeClock(1000000, 0);
+    FrequencySensor fast(PulseInput::NO_PIN, RPM_SCALE);
+    PulseTrainGenerator generator(&fast, 10);
+    generator.init();
+    run(&generator, &fast, 1000, 100);
+    CHECK_EQUAL(32767, fast.raw());
+    stubRealClock();
+}
+
+// the average high time since the previous tick, at any duty cycle
+static void testPulseWidth(void) {
+    const byte duties[] = {10, 25, 50, 90};
+    for (byte i = 0; i < 4; i++) {
+        stubFakeClock(1000000, 0);
+        PulseWidthSensor injector(PulseInput::NO_PIN);
+        PulseTrainGenerator generator(&injector, 8000, duties[i]);
+        injector.init();
+        generator.init();
+        run(&generator, &injector, 50000, 1000);
+        CHECK_EQUAL(80L * duties[i], injector.raw());
+        CHECK(strcmp("us", injector.unit()) == 0);
+    }
+    stubRealClock();
+}
+
+// ticks without a whole pulse keep the last width, until the timeout
+static void testPulseWidthTimeout(void) {
+    stubFakeClock(1000000, 0);
+    PulseWidthSensor injector(PulseInput::NO_PIN, 20000);
+    PulseTrainGenerator generator(&injector, 10000, 30);
+    generator.init();
+    run(&generator, &injector, 30000, 1000);
+    CHECK_EQUAL(3000, injector.raw());
+    unsigned long sampledAt = injector.getSampledAt();
+
+    generator.setPeriod(0);
+    run(&generator, &injector, 15000, 1000);
+    CHECK_EQUAL(3000, injector.raw());
+    CHECK(injector.getSampledAt() > sampledAt);
+    run(&generator, &injector, 15000, 1000);
+    CHECK_EQUAL(0, injector.raw());
+
+    generator.setPeriod(5000);
+    run(&generator, &injector, 20000, 1000);
+    CHECK_EQUAL(1500, injector.raw());
+    stubRealClock();
+}
+
+class CountingInput : public PulseInput {
+public:
+    int edges = 0;
+    unsigned long firstAt = 0;
+    void edge(unsigned long at, bool level) {
+        if (this->edges++ == 0) {
+            this->firstAt = at;
+        }
+    }
+};
+
+// a stopped generator starts over when it gets a period again, instead
+//  of sending every edge it missed at once
+static void testGeneratorRestart(void) {
+    stubFakeClock(1000000, 0);
+    CountingInput input;
+    PulseTrainGenerator generator(&input, 1000);
+    generator.init();
+    stubAdvance(10000);
+    generator.tick();
+    CHECK_EQUAL(21, input.edges);
+
+    generator.setPeriod(0);
+    stubAdvance(100000);
+    generator.tick();
+    CHECK_EQUAL(21, input.edges);
+
+    input.edges = 0;
+    generator.setPeriod(1000);
+    unsigned long restartedAt = micros();
+    generator.tick();
+    CHECK_EQUAL(1, input.edges);
+    CHECK_EQUAL(restartedAt, input.firstAt);
+    stubRealClock();
+}
+
+// in a gauge, with the generator added before the sensor it feeds
+static void testInGauge(void) {
+    stubFakeClock(1000000, 0);
+    FrequencySensor tach(PulseInput::NO_PIN, RPM_SCALE);
+    PulseTrainGenerator generator(&tach, RPM_SCALE / 4500);
+    CompositeGauge gauge;
+    gauge.add(&generator);
+    gauge.add(&tach);
+    for (byte i = 0; i < 50; i++) {
+        stubAdvance(1000);
+        gauge.tick();
+    }
+    CHECK(abs(tach.raw() - 4500) <= 45);
+    stubRealClock();
+}
+
+int main(void) {
+    testSteadySignal();
+    testFirstEdge();
+    testResumeAfterTimeout();
+    testClamp();
+    testPulseWidth();
+    testPulseWidthTimeout();
+    testGeneratorRestart();
+    testInGauge();
+    return TEST_RESULT();
+}
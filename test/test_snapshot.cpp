@@ -0,0 +1,192 @@
+#include <signal.h>
+#include <sys/time.h>
+#include "concurrent.h"
+#include "test.h"
+
+static const unsigned long STRESS_MICROS = 500000;
+
+/**
+ * Writes 'value' in decimal, by hand: much quicker than snprintf(), which
+ *  keeps the copy in load() a bigger share of the reader's time
+ */
+static void formatCount(int value, char *buffer) {
+    char digits[DataSource::FORMAT_SIZE];
+    byte length = 0;
+    do {
+        digits[length++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    for (byte i = 0; i < length; i++) {
+        buffer[i] = digits[length - 1 - i];
+    }
+    buffer[length] = '\0';
+}
+
+/**
+ * Counts up, the three values it exposes always agree with each other:
+ *  sampledAt is 3 * raw + 1 and the formatted value is raw in decimal
+ */
+class CountingSource : public SourceComponent {
+    int count = 0;
+public:
+    void init(void) {}
+    void read(void) {
+        this->count = (this->count + 1) % 1000000000;
+        this->sampledAt = this->count * 3UL + 1;
+    }
+    void tick(void) { this->read(); }
+    int raw(void) { return this->count; }
+    const char *unit(void) { return ""; }
+    void formatTo(char *buffer) { formatCount(this->count, buffer); }
+};
+
+class CheckedSnapshot : public SnapshotSource {
+public:
+    static const byte BATCH = 32;
+    unsigned long loads = 0;
+    unsigned long torn = 0;
+    unsigned long backwards = 0;
+    int last = -1;
+    CheckedSnapshot(DataSource *source) : SnapshotSource(source) {}
+
+    // loads a batch back to back and checks it afterwards, so the reader
+    //  spends most of its time inside load() where a tear would happen
+    void check(void) {
+        SourceSnapshot snapshots[BATCH];
+        for (byte i = 0; i < BATCH; i++) {
+            snapshots[i] = this->load();
+        }
+        for (byte i = 0; i < BATCH; i++) {
+            SourceSnapshot &snapshot = snapshots[i];
+            char expected[DataSource::FORMAT_SIZE];
+            formatCount(snapshot.raw, expected);
+            if (snapshot.raw != 0 && (snapshot.sampledAt != snapshot.raw * 3UL + 1 || strcmp(expected, snapshot.formatted) != 0)) {
+                this->torn++;
+            }
+            if (snapshot.raw < this->last) {
+                this->backwards++;
+            }
+            this->last = snapshot.raw;
+        }
+        this->loads += BATCH;
+    }
+};
+
+/**
+ * Display side component, checks every snapshot it gets
+ */
+class SnapshotChecker : public GaugeComponent {
+    CheckedSnapshot *snapshot;
+public:
+    SnapshotChecker(CheckedSnapshot *snapshot) : GaugeComponent() {
+        this->snapshot = snapshot;
+    }
+    void init(void) {}
+    void tick(void) { this->snapshot->check(); }
+};
+
+static CountingSource *publishedSource;
+static CheckedSnapshot *publishedSnapshot;
+static volatile bool publishing;
+
+static void *publisher(void *unused) {
+    while (publishing) {
+        publishedSource->read();
+        publishedSnapshot->publish();
+    }
+    return NULL;
+}
+
+// one thread publishes as fast as it can, the other never gets a torn
+//  or an older snapshot back
+static void testPublishLoadStress(void) {
+    CountingSource source;
+    CheckedSnapshot snapshot(&source);
+    publishedSource = &source;
+    publishedSnapshot = &snapshot;
+    publishing = true;
+    pthread_t thread;
+    pthread_create(&thread, NULL, &publisher, NULL);
+    unsigned long start = micros();
+    while (micros() - start < STRESS_MICROS) {
+        for (int i = 0; i < 100; i++) {
+            snapshot.check();
+        }
+    }
+    publishing = false;
+    pthread_join(thread, NULL);
+    snapshot.check();
+
+    CHECK(snapshot.loads > 1000);
+    CHECK_EQUAL(0, snapshot.torn);
+    CHECK_EQUAL(0, snapshot.backwards);
+    CHECK_EQUAL(source.raw(), snapshot.last);
+}
+
+static void publishTwice(int signal) {
+    for (byte i = 0; i < 2; i++) {
+        publishedSource->read();
+        publishedSnapshot->publish();
+    }
+}
+
+// the same, with the publishes coming from a timer signal in the middle of
+//  the reader's own work, like an interrupt (or the other core lapping
+//  it) would: on a single core two threads hardly ever interleave inside
+//  the copy, a signal every 20us lands there thousands of times
+static void testPublishFromInterrupt(void) {
+    CountingSource source;
+    CheckedSnapshot snapshot(&source);
+    publishedSource = &source;
+    publishedSnapshot = &snapshot;
+    signal(SIGALRM, &publishTwice);
+    struct itimerval timer = {{0, 20}, {0, 20}};
+    setitimer(ITIMER_REAL, &timer, NULL);
+    unsigned long start = micros();
+    while (micros() - start < 2 * STRESS_MICROS) {
+        for (int i = 0; i < 100; i++) {
+            snapshot.check();
+        }
+    }
+    struct itimerval off = {{0, 0}, {0, 0}};
+    setitimer(ITIMER_REAL, &off, NULL);
+    signal(SIGALRM, SIG_DFL);
+
+    CHECK(source.raw() > 1000);
+    CHECK_EQUAL(0, snapshot.torn);
+    CHECK_EQUAL(0, snapshot.backwards);
+}
+
+// same thing through the gauge, each stage on its own thread
+static void testDualCoreGauge(void) {
+    DualCoreGauge gauge;
+    CountingSource source;
+    CheckedSnapshot snapshot(&source);
+    SnapshotChecker checker(&snapshot);
+    CHECK(gauge.add(&source));
+    CHECK(gauge.add(&checker));
+    CHECK(gauge.share(&snapshot));
+    gauge.init();
+    gauge.tick();
+    delay(STRESS_MICROS / 1000);
+    gauge.stop();
+
+    CHECK(gauge.samplingTicks > 1000);
+    CHECK(gauge.displayTicks > 1000);
+    CHECK_EQUAL(gauge.displayTicks * CheckedSnapshot::BATCH, snapshot.loads);
+    CHECK_EQUAL(0, snapshot.torn);
+    CHECK_EQUAL(0, snapshot.backwards);
+
+    // stopped, tick() runs both stages in sequence again
+    unsigned long samplingTicks = gauge.samplingTicks;
+    gauge.tick();
+    CHECK_EQUAL(samplingTicks + 1, gauge.samplingTicks);
+    CHECK_EQUAL(source.raw(), snapshot.last);
+}
+
+int main(void) {
+    testPublishLoadStress();
+    testPublishFromInterrupt();
+    testDualCoreGauge();
+    return TEST_RESULT();
+}
@@ -0,0 +1,134 @@
+#include <new>
+#include "gauge_fw.h"
+#include "datasource.h"
+#include "display.h"
+#include "calibration.h"
+#include "arena.h"
+#include "test.h"
+
+// a gauge with one of every component that uses the arena, ticked for a
+//  few million times on the fake clock: once it's running, neither the
+//  heap nor the arena may grow any more
+
+static const unsigned long WARM_UP = 10000;
+static const unsigned long TICKS = 2000000;
+
+static unsigned long allocations = 0;
+static long heapBytes = 0;
+
+// the size goes in front of every block, so delete knows what it frees
+void *operator new(size_t size) {
+    size_t *block = (size_t*) malloc(size + sizeof(max_align_t));
+    if (block == NULL) {
+        throw std::bad_alloc();
+    }
+    *block = size;
+    allocations++;
+    heapBytes += size;
+    return (byte*) block + sizeof(max_align_t);
+}
+
+void operator delete(void *pointer) noexcept {
+    if (pointer == NULL) {
+        return;
+    }
+    size_t *block = (size_t*) ((byte*) pointer - sizeof(max_align_t));
+    heapBytes -= *block;
+    free(block);
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete[](void *pointer) noexcept {
+    operator delete(pointer);
+}
+
+void operator delete(void *pointer, size_t size) noexcept {
+    operator delete(pointer);
+}
+
+void operator delete[](void *pointer, size_t size) noexcept {
+    operator delete(pointer);
+}
+
+static int difference(int *values, byte count) {
+    return values[0] - values[1];
+}
+
+static const CalibrationPoint fuelTable[] = {{100, 0}, {300, 250}, {600, 600}, {900, 1000}};
+
+int main(void) {
+    stubFakeClock(1000000);
+    Arena *arena = Arena::framework();
+    arena->reset();
+
+    CompositeGauge gauge;
+    TestSensor sweeping(175, 440, 3);
+    MPX4250Sensor boost(0);
+    MPX5500Sensor backpressure(1);
+    MPXSensor *pressures[] = {&boost, &backpressure};
+    MPXSensorBank bank(pressures, 2);
+    vector<DataSource*> inputs = {&boost, &backpressure};
+    DerivedSource delta(&inputs, &difference, "kpa", 10);
+    CalibrationCurve fuelCurve(fuelTable, 4);
+    CalibratedSensor fuel(2, &fuelCurve, "%", 10);
+
+    vector<int> sweepLeds = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    vector<int> alertLeds = {11};
+    int base[3] = {25, 8, 0}, alert[3] = {255, 0, 0}, blank[3] = {0, 0, 0};
+    SingleSweepLEDStrip ring(&sweeping, 6, 12, 175, 440, 400, base, blank, alert, &sweepLeds, &alertLeds);
+
+    FullSweepIlluminationStrategy strategy;
+    IndAddrLEDStripSweep fuelSweep(&fuel, 0, 100, 90, base, alert, blank, &sweepLeds, &alertLeds, &strategy);
+    IndAddrLEDStripSweep deltaSweep(&delta, -500, 500, 400, base, alert, blank, &sweepLeds, &alertLeds, &strategy);
+    vector<IndAddrLEDStripSweep*> sweeps = {&fuelSweep, &deltaSweep};
+    const byte pins[] = {2, 4};
+    const word counts[] = {6, 6};
+    ParallelLEDOutput output(pins, counts, 2);
+    MultiSweepLEDStrip strip(&sweeps, &output);
+    DualDataSourceScreen screen(&delta, &fuel, 15, 0x3C, &SH1106_128x64, -1);
+
+    LatencyHistogram ringLatency, stripLatency;
+    ring.setLatencyHistogram(&ringLatency);
+    strip.setLatencyHistogram(&stripLatency);
+
+    CHECK(gauge.add(&screen));
+    CHECK(gauge.add(&strip));
+    CHECK(gauge.add(&ring));
+    CHECK(gauge.add(&delta));
+    CHECK(gauge.add(&fuel));
+    CHECK(gauge.add(&bank));
+    CHECK(gauge.add(&sweeping));
+    gauge.init();
+
+    unsigned long tick = 0;
+    for (; tick < WARM_UP; tick++) {
+        stubAnalog[0] = 300 + tick % 400;
+        stubAnalog[1] = 200 + tick % 150;
+        stubAnalog[2] = 100 + tick % 800;
+        gauge.tick();
+    }
+
+    unsigned long allocationsBefore = allocations;
+    long heapBefore = heapBytes;
+    size_t highWaterMark = arena->getHighWaterMark();
+    word failures = arena->getFailures();
+
+    for (; tick < WARM_UP + TICKS; tick++) {
+        stubAnalog[0] = 300 + tick % 400;
+        stubAnalog[1] = 200 + tick % 150;
+        stubAnalog[2] = 100 + tick % 800;
+        gauge.tick();
+    }
+
+    CHECK_EQUAL(allocationsBefore, allocations);
+    CHECK_EQUAL(heapBefore, heapBytes);
+    CHECK_EQUAL(highWaterMark, arena->getHighWaterMark());
+    CHECK_EQUAL(failures, arena->getFailures());
+    CHECK_EQUAL(0, failures);
+    CHECK(ringLatency.count > 0 && stripLatency.count > 0);
+    stubRealClock();
+    return TEST_RESULT();
+}
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""
+Builds and validates binary gauge descriptions for GaugeConfig (gauge_config.h)
+
+    gauge_config.py build layout.json layout.bin [--c-array name]
+    gauge_config.py validate layout.bin
+
+A layout is a JSON document like:
+
+    {
+      "sensors": [
+        {"type": "test", "min": 175, "max": 440, "speed": 11},
+        {"type": "mpx5500", "pin": 0, "adcValueOffset": 40, "error": 0.0025}
+      ],
+      "sweeps": [
+        {"sensor": 0, "min": 175, "max": 410, "alert": 400,
+         "base": [2, 2, 1], "alertColor": [255, 0, 0], "blank": [0, 0, 0],
+         "strategy": "full", "radio": 0,
+         "leds": [6, 7, 8, 9], "alertLeds": [17]}
+      ],
+      "strips": [{"pin": 2, "leds": 24, "sweeps": [0]}],
+      "screens": [
+        {"type": "dual", "address": 60, "screen": "sh1106_128x64", "resetPin": -1,
+         "top": 0, "bottom": 1, "x": 15}
+      ]
+    }
+"""
+import json
+import struct
+import sys
+
+MAGIC = b'GF'
+VERSION = 1
+# CompositeGauge::MAX_COMPONENTS
+MAX_COMPONENTS = 16
+# GaugeConfig::MAX_SWEEPS
+MAX_SWEEPS = 16
+
+SENSORS = {'test': 0, 'mpx4250': 1, 'mpx5500': 2}
+STRATEGIES = {'full': 0, 'inverse': 1, 'level': 2}
+SCREENS = {'single': 0, 'dual': 1}
+SCREEN_TYPES = {'sh1106_128x64': 0, 'adafruit128x64': 1, 'adafruit128x32': 2}
+
+
+def byte(value):
+    return struct.pack('<B', value & 0xff)
+
+
+def word(value):
+    return struct.pack('<H', value & 0xffff)
+
+
+def leds(values):
+    return byte(len(values)) + b''.join(word(led) for led in values)
+
+
+def build(layout):
+    out = bytearray(MAGIC + byte(VERSION))
+
+    sensors = layout.get('sensors', [])
+    out += byte(len(sensors))
+    for sensor in sensors:
+        out += byte(SENSORS[sensor['type']])
+        if sensor['type'] == 'test':
+            out += word(sensor['min']) + word(sensor['max']) + byte(sensor['speed'])
+        else:
+            out += byte(sensor['pin']) + byte(sensor.get('adcValueOffset', 0))
+            out += word(round(sensor.get('error', 0) * 10000))
+
+    sweeps = layout.get('sweeps', [])
+    out += byte(len(sweeps))
+    for sweep in sweeps:
+        out += byte(sweep['sensor'])
+        out += word(sweep['min']) + word(sweep['max']) + word(sweep['alert'])
+        for color in ('base', 'alertColor', 'blank'):
+            out += bytes(sweep[color])
+        out += byte(STRATEGIES[sweep.get('strategy', 'full')]) + byte(sweep.get('radio', 0))
+        out += leds(sweep['leds']) + leds(sweep.get('alertLeds', []))
+
+    strips = layout.get('strips', [])
+    out += byte(len(strips))
+    for strip in strips:
+        out += byte(strip['pin']) + word(strip['leds'])
+        out += byte(len(strip['sweeps'])) + bytes(strip['sweeps'])
+
+    screens = layout.get('screens', [])
+    out += byte(len(screens))
+    for screen in screens:
+        out += byte(SCREENS[screen['type']]) + byte(screen['address'])
+        out += byte(SCREEN_TYPES[screen['screen']]) + byte(screen.get('resetPin', -1))
+        if screen['type'] == 'single':
+            out += byte(screen['sensor']) + byte(screen.get('x', 0))
+            out += byte(screen.get('y', 0)) + byte(screen.get('unitY', 0))
+        else:
+            out += byte(screen['top']) + byte(screen['bottom']) + byte(screen.get('x', 0))
+
+    out += byte(sum(out))
+    return bytes(out)
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.position = 0
+
+    def next(self):
+        if self.position >= len(self.data):
+            raise ValueError('truncated at byte %d' % self.position)
+        value = self.data[self.position]
+        self.position += 1
+        return value
+
+    def word(self):
+        return self.next() | (self.next() << 8)
+
+    def skip(self, count):
+        for _ in range(count):
+            self.next()
+
+
+def validate(data):
+    """Same checks GaugeConfig::validate() does on the device"""
+    reader = Reader(data)
+    if bytes([reader.next(), reader.next()]) != MAGIC or reader.next() != VERSION:
+        raise ValueError('bad header')
+
+    sensor_count = reader.next()
+    components = sensor_count
+    for i in range(sensor_count):
+        sensor_type = reader.next()
+        if sensor_type == SENSORS['test']:
+            reader.skip(5)
+        elif sensor_type in (SENSORS['mpx4250'], SENSORS['mpx5500']):
+            reader.skip(4)
+        else:
+            raise ValueError('sensor %d: unknown type %d' % (i, sensor_type))
+
+    sweep_count = reader.next()
+    if sweep_count > MAX_SWEEPS:
+        raise ValueError('%d sweeps, a layout holds %d' % (sweep_count, MAX_SWEEPS))
+    # how long a strip showing each sweep has to be
+    leds_needed = []
+    for i in range(sweep_count):
+        if reader.next() >= sensor_count:
+            raise ValueError('sweep %d: unknown sensor' % i)
+        reader.skip(6 + 9)
+        if reader.next() > STRATEGIES['level']:
+            raise ValueError('sweep %d: unknown strategy' % i)
+        reader.skip(1)
+        needed = 0
+        for _ in range(2):
+            for _ in range(reader.next()):
+                needed = max(needed, reader.word() + 1)
+        leds_needed.append(needed)
+
+    strip_count = reader.next()
+    components += strip_count
+    for i in range(strip_count):
+        reader.skip(1)
+        strip_leds = reader.word()
+        for _ in range(reader.next()):
+            sweep = reader.next()
+            if sweep >= sweep_count:
+                raise ValueError('strip %d: unknown sweep' % i)
+            if leds_needed[sweep] > strip_leds:
+                raise ValueError('strip %d: sweep %d lights LED %d, the strip has %d'
+                                 % (i, sweep, leds_needed[sweep] - 1, strip_leds))
+
+    screen_count = reader.next()
+    components += screen_count
+    for i in range(screen_count):
+        screen_type = reader.next()
+        reader.skip(1)
+        if reader.next() not in SCREEN_TYPES.values():
+            raise ValueError('screen %d: unknown screen type' % i)
+        reader.skip(1)
+        if screen_type == SCREENS['single']:
+            if reader.next() >= sensor_count:
+                raise ValueError('screen %d: unknown sensor' % i)
+            reader.skip(3)
+        elif screen_type == SCREENS['dual']:
+            if reader.next() >= sensor_count or reader.next() >= sensor_count:
+                raise ValueError('screen %d: unknown sensor' % i)
+            reader.skip(1)
+        else:
+            raise ValueError('screen %d: unknown type %d' % (i, screen_type))
+
+    checksum = sum(data[:reader.position]) & 0xff
+    if reader.next() != checksum:
+        raise ValueError('bad checksum')
+    if components > MAX_COMPONENTS:
+        raise ValueError('%d components, a gauge holds %d' % (components, MAX_COMPONENTS))
+    return reader.position
+
+
+def c_array(name, data):
+    lines = []
+    for i in range(0, len(data), 12):
+        lines.append('  ' + ', '.join('0x%02x' % value for value in data[i:i + 12]) + ',')
+    return 'const byte %s[%d] PROGMEM = {\n%s\n};\n' % (name, len(data), '\n'.join(lines))
+
+
+def main(args):
+    if len(args) >= 3 and args[0] == 'build':
+        with open(args[1]) as source:
+            data = build(json.load(source))
+        validate(data)
+        with open(args[2], 'wb') as target:
+            target.write(data)
+        if len(args) == 5 and args[3] == '--c-array':
+            sys.stdout.write(c_array(args[4], data))
+        print('%d bytes' % len(data), file=sys.stderr)
+    elif len(args) == 2 and args[0] == 'validate':
+        with open(args[1], 'rb') as source:
+            data = source.read()
+        try:
+            length = validate(data)
+        except ValueError as error:
+            print('invalid: %s' % error, file=sys.stderr)
+            return 1
+        print('valid, %d bytes' % length, file=sys.stderr)
+    else:
+        print(__doc__, file=sys.stderr)
+        return 2
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))